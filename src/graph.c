@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "types.h"
+#include "hash.h"
+#include "graph.h"
+
+void graphInit(Graph *graph){
+  graph->rows = 0;
+  graph->rowStart = NULL;
+  graph->rowSize = NULL;
+  graph->targets = NULL;
+  graph->lengths = NULL;
+  graph->years = NULL;
+  graph->edges = NULL;
+  graph->dirty = true;
+}
+
+void graphFree(Graph *graph){
+  free(graph->rowStart);
+  free(graph->rowSize);
+  free(graph->targets);
+  free(graph->lengths);
+  free(graph->years);
+  free(graph->edges);
+  graphInit(graph);
+}
+
+static bool findEdge(Graph *graph, Neigh *neighPtr, uint32_t *position){
+  uint32_t from = neighPtr->reversed->dest->id;
+  if(graph->dirty || from >= graph->rows) return false;
+
+  uint32_t end = graph->rowStart[from] + graph->rowSize[from];
+  for(uint32_t k = graph->rowStart[from]; k < end; k++){
+    if(graph->edges[k] == neighPtr){
+      *position = k;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void setEdge(Graph *graph, uint32_t k, Neigh *neighPtr){
+  graph->targets[k] = neighPtr->dest->id;
+  graph->lengths[k] = neighPtr->length;
+  graph->years[k] = neighPtr->date;
+  graph->edges[k] = neighPtr;
+}
+
+void graphAddEdge(Graph *graph, Neigh *neighPtr){
+  if(graph->dirty) return;
+
+  uint32_t from = neighPtr->reversed->dest->id;
+  if(from >= graph->rows || graph->rowStart[from] + graph->rowSize[from] == graph->rowStart[from + 1]){
+    graph->dirty = true;
+    return;
+  }
+
+  setEdge(graph, graph->rowStart[from] + graph->rowSize[from], neighPtr);
+  graph->rowSize[from]++;
+}
+
+void graphRemoveEdge(Graph *graph, Neigh *neighPtr){
+  uint32_t k;
+  if(!findEdge(graph, neighPtr, &k)) return;
+
+  uint32_t from = neighPtr->reversed->dest->id;
+  uint32_t last = graph->rowStart[from] + graph->rowSize[from] - 1;
+  setEdge(graph, k, graph->edges[last]);
+  graph->rowSize[from]--;
+}
+
+void graphUpdateEdge(Graph *graph, Neigh *neighPtr){
+  uint32_t k;
+  if(findEdge(graph, neighPtr, &k)) graph->years[k] = neighPtr->date;
+}
+
+static bool growArray(void **array, uint32_t count, size_t size){
+  void *newArray = realloc(*array, count * size);
+  if(newArray == NULL) return false;
+  *array = newArray;
+  return true;
+}
+
+bool graphSync(Graph *graph, CityTable *cities, EdgeTable *roads){
+  if(!graph->dirty) return true;
+
+  uint32_t rows = cities->count;
+  if(!growArray((void**)&(graph->rowStart), rows + 1, sizeof(uint32_t))) return false;
+  if(!growArray((void**)&(graph->rowSize), rows + 1, sizeof(uint32_t))) return false;
+
+  for(uint32_t i = 0; i < rows; i++) graph->rowSize[i] = 0;
+  for(uint32_t i = 0; i < roads->slotsCount; i++){
+    Neigh *neighPtr = roads->slots[i].neigh;
+    if(neighPtr == NULL) continue;
+    graph->rowSize[neighPtr->dest->id]++;
+    graph->rowSize[neighPtr->reversed->dest->id]++;
+  }
+
+  // Każdy wiersz dostaje zapas na połowę swoich odcinków (i co najmniej dwa),
+  // żeby kolejne addRoad rzadko wymuszały przebudowę.
+  uint32_t total = 0;
+  for(uint32_t i = 0; i < rows; i++){
+    graph->rowStart[i] = total;
+    total += graph->rowSize[i] + graph->rowSize[i] / 2 + 2;
+    graph->rowSize[i] = 0;
+  }
+  graph->rowStart[rows] = total;
+
+  uint32_t slots = total == 0 ? 1 : total;
+  if(!growArray((void**)&(graph->targets), slots, sizeof(uint32_t))) return false;
+  if(!growArray((void**)&(graph->lengths), slots, sizeof(uint32_t))) return false;
+  if(!growArray((void**)&(graph->years), slots, sizeof(int32_t))) return false;
+  if(!growArray((void**)&(graph->edges), slots, sizeof(Neigh*))) return false;
+
+  graph->rows = rows;
+  graph->dirty = false;
+  for(uint32_t i = 0; i < roads->slotsCount; i++){
+    Neigh *neighPtr = roads->slots[i].neigh;
+    if(neighPtr == NULL) continue;
+    graphAddEdge(graph, neighPtr);
+    graphAddEdge(graph, neighPtr->reversed);
+  }
+  return true;
+}
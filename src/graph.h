@@ -0,0 +1,77 @@
+/** @file
+ * Spłaszczona reprezentacja sieci dróg (CSR) używana przez wyszukiwanie
+ * najkrótszych ścieżek.
+ *
+ * @author Jakub Organa
+ * @date 17.10.2026
+ */
+
+#ifndef __GRAPH_H__
+#define __GRAPH_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include "types.h"
+#include "hash.h"
+
+/**
+ * Listy sąsiedztwa wszystkich miast w jednej tablicy. Wiersz miasta o
+ * identyfikatorze i zajmuje pozycje od rowStart[i] do rowStart[i + 1] - 1,
+ * z których pierwsze rowSize[i] są zajęte; zapas pozwala dopisywać nowe
+ * odcinki bez przebudowy. Gdy zapas się skończy, reprezentacja jest
+ * oznaczana jako nieaktualna i przebudowywana z indeksu odcinków dopiero
+ * przed następnym wyszukiwaniem.
+ */
+typedef struct Graph {
+  /*@{*/
+  uint32_t rows; /**< liczba wierszy */
+  uint32_t *rowStart; /**< początki wierszy (rows + 1 wartości) */
+  uint32_t *rowSize; /**< liczby odcinków w wierszach */
+  uint32_t *targets; /**< identyfikatory miast docelowych */
+  uint32_t *lengths; /**< długości odcinków */
+  int32_t *years; /**< lata budowy lub ostatniego remontu */
+  Neigh **edges; /**< odcinki, którym odpowiadają pozycje */
+  bool dirty; /**< informacja, czy reprezentacja wymaga przebudowy */
+  /*@}*/
+} Graph;
+
+/** @brief Inicjalizuje pustą reprezentację (wymagającą zbudowania).
+ * @param[out] graph      - wskaźnik na graf
+ */
+void graphInit(Graph *graph);
+
+/** @brief Zwalnia pamięć reprezentacji.
+ * @param[in, out] graph      - wskaźnik na graf
+ */
+void graphFree(Graph *graph);
+
+/** @brief Dopisuje odcinek do wiersza miasta, z którego wychodzi.
+ * Jeśli w wierszu nie ma miejsca, oznacza reprezentację jako nieaktualną.
+ * @param[in, out] graph      - wskaźnik na graf
+ * @param[in] neighPtr      - wskaźnik na odcinek
+ */
+void graphAddEdge(Graph *graph, Neigh *neighPtr);
+
+/** @brief Usuwa odcinek z wiersza miasta, z którego wychodzi.
+ * @param[in, out] graph      - wskaźnik na graf
+ * @param[in] neighPtr      - wskaźnik na odcinek
+ */
+void graphRemoveEdge(Graph *graph, Neigh *neighPtr);
+
+/** @brief Przepisuje rok ostatniego remontu odcinka.
+ * @param[in, out] graph      - wskaźnik na graf
+ * @param[in] neighPtr      - wskaźnik na odcinek
+ */
+void graphUpdateEdge(Graph *graph, Neigh *neighPtr);
+
+/** @brief Przebudowuje reprezentację, jeśli jest nieaktualna.
+ * @param[in, out] graph      - wskaźnik na graf
+ * @param[in] cities      - wskaźnik na tablicę miast
+ * @param[in] roads      - wskaźnik na indeks odcinków
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool graphSync(Graph *graph, CityTable *cities, EdgeTable *roads);
+
+#endif /* __GRAPH_H__ */
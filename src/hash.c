@@ -0,0 +1,342 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "types.h"
+#include "hash.h"
+
+static const uint32_t INITIAL_SLOTS = 16;
+
+uint32_t hashName(const char *name){
+  uint32_t hash = 2166136261u;
+  while(*name != 0){
+    hash ^= (uint8_t)(*name);
+    hash *= 16777619u;
+    name++;
+  }
+  return hash;
+}
+
+//CITIES
+
+bool cityTableInit(CityTable *table){
+  table->slots = (uint32_t*)calloc(INITIAL_SLOTS, sizeof(uint32_t));
+  if(table->slots == NULL) return false;
+  table->slotsCount = INITIAL_SLOTS;
+
+  table->cities = NULL;
+  table->count = 0;
+  table->capacity = 0;
+  return true;
+}
+
+static void placeCity(uint32_t *slots, uint32_t mask, City *cityPtr){
+  uint32_t i = cityPtr->hash & mask;
+  while(slots[i] != 0) i = (i + 1) & mask;
+  slots[i] = cityPtr->id + 1;
+}
+
+static bool growSlots(CityTable *table){
+  uint32_t newCount = table->slotsCount * 2;
+  uint32_t *newSlots = (uint32_t*)calloc(newCount, sizeof(uint32_t));
+  if(newSlots == NULL) return false;
+
+  for(uint32_t id = 0; id < table->count; id++){
+    placeCity(newSlots, newCount - 1, table->cities[id]);
+  }
+
+  free(table->slots);
+  table->slots = newSlots;
+  table->slotsCount = newCount;
+  return true;
+}
+
+City *cityTableFind(CityTable *table, const char *name){
+  uint32_t mask = table->slotsCount - 1;
+  uint32_t hash = hashName(name);
+  uint32_t i = hash & mask;
+
+  while(table->slots[i] != 0){
+    City *cityPtr = table->cities[table->slots[i] - 1];
+    if(cityPtr->hash == hash && strcmp(cityPtr->name, name) == 0) return cityPtr;
+    i = (i + 1) & mask;
+  }
+  return NULL;
+}
+
+bool cityTableAdd(CityTable *table, City *cityPtr){
+  if(table->count == table->capacity){
+    uint32_t newCapacity = table->capacity == 0 ? INITIAL_SLOTS : 2 * table->capacity;
+    City **newCities = (City**)realloc(table->cities, newCapacity * sizeof(City*));
+    if(newCities == NULL) return false;
+    table->cities = newCities;
+    table->capacity = newCapacity;
+  }
+
+  // Współczynnik zapełnienia nie przekracza 1/2.
+  if(2 * (table->count + 1) > table->slotsCount){
+    if(!growSlots(table)) return false;
+  }
+
+  cityPtr->id = table->count;
+  cityPtr->hash = hashName(cityPtr->name);
+  table->cities[table->count] = cityPtr;
+  table->count++;
+  placeCity(table->slots, table->slotsCount - 1, cityPtr);
+  return true;
+}
+
+void cityTableRemoveLast(CityTable *table){
+  uint32_t mask = table->slotsCount - 1;
+  City *cityPtr = table->cities[table->count - 1];
+  uint32_t i = cityPtr->hash & mask;
+  while(table->slots[i] != cityPtr->id + 1) i = (i + 1) & mask;
+
+  // Usuwanie z przesunięciem wstecz: kolejne elementy klastra, których
+  // kubełek docelowy nie leży między wolnym miejscem a ich pozycją, przesuwamy.
+  uint32_t j = i;
+  while(true){
+    table->slots[i] = 0;
+    while(true){
+      j = (j + 1) & mask;
+      if(table->slots[j] == 0){
+        table->count--;
+        return;
+      }
+      uint32_t k = table->cities[table->slots[j] - 1]->hash & mask;
+      if((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) continue;
+      break;
+    }
+    table->slots[i] = table->slots[j];
+    i = j;
+  }
+}
+
+void cityTableFree(CityTable *table){
+  free(table->cities);
+  table->cities = NULL;
+  free(table->slots);
+  table->slots = NULL;
+  table->count = 0;
+  table->capacity = 0;
+  table->slotsCount = 0;
+}
+
+//ROADS
+
+static uint64_t edgeKey(City *cityPtr1, City *cityPtr2){
+  uint64_t a = cityPtr1->id;
+  uint64_t b = cityPtr2->id;
+  if(a > b) return (b << 32) | a;
+  return (a << 32) | b;
+}
+
+uint32_t hashKey(uint64_t key){
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  return (uint32_t)key;
+}
+
+bool edgeTableInit(EdgeTable *table){
+  table->slots = (EdgeSlot*)calloc(INITIAL_SLOTS, sizeof(EdgeSlot));
+  if(table->slots == NULL) return false;
+  table->slotsCount = INITIAL_SLOTS;
+  table->count = 0;
+  return true;
+}
+
+static void placeEdge(EdgeSlot *slots, uint32_t mask, uint64_t key, Neigh *neighPtr){
+  uint32_t i = hashKey(key) & mask;
+  while(slots[i].neigh != NULL) i = (i + 1) & mask;
+  slots[i].key = key;
+  slots[i].neigh = neighPtr;
+}
+
+static bool growEdgeSlots(EdgeTable *table){
+  uint32_t newCount = table->slotsCount * 2;
+  EdgeSlot *newSlots = (EdgeSlot*)calloc(newCount, sizeof(EdgeSlot));
+  if(newSlots == NULL) return false;
+
+  for(uint32_t i = 0; i < table->slotsCount; i++){
+    if(table->slots[i].neigh != NULL){
+      placeEdge(newSlots, newCount - 1, table->slots[i].key, table->slots[i].neigh);
+    }
+  }
+
+  free(table->slots);
+  table->slots = newSlots;
+  table->slotsCount = newCount;
+  return true;
+}
+
+static uint32_t findEdgeSlot(EdgeTable *table, uint64_t key){
+  uint32_t mask = table->slotsCount - 1;
+  uint32_t i = hashKey(key) & mask;
+  while(table->slots[i].neigh != NULL && table->slots[i].key != key) i = (i + 1) & mask;
+  return i;
+}
+
+Neigh *edgeTableFind(EdgeTable *table, City *cityPtr1, City *cityPtr2){
+  Neigh *neighPtr = table->slots[findEdgeSlot(table, edgeKey(cityPtr1, cityPtr2))].neigh;
+  if(neighPtr == NULL) return NULL;
+  if(neighPtr->dest == cityPtr2) return neighPtr;
+  return neighPtr->reversed;
+}
+
+bool edgeTableAdd(EdgeTable *table, Neigh *neighPtr){
+  if(2 * (table->count + 1) > table->slotsCount){
+    if(!growEdgeSlots(table)) return false;
+  }
+
+  City *from = neighPtr->reversed->dest;
+  City *to = neighPtr->dest;
+  if(from->id > to->id) neighPtr = neighPtr->reversed;
+
+  placeEdge(table->slots, table->slotsCount - 1, edgeKey(from, to), neighPtr);
+  table->count++;
+  return true;
+}
+
+void edgeTableRemove(EdgeTable *table, Neigh *neighPtr){
+  uint32_t mask = table->slotsCount - 1;
+  uint32_t i = findEdgeSlot(table, edgeKey(neighPtr->reversed->dest, neighPtr->dest));
+  if(table->slots[i].neigh == NULL) return;
+
+  uint32_t j = i;
+  while(true){
+    table->slots[i].neigh = NULL;
+    while(true){
+      j = (j + 1) & mask;
+      if(table->slots[j].neigh == NULL){
+        table->count--;
+        return;
+      }
+      uint32_t k = hashKey(table->slots[j].key) & mask;
+      if((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) continue;
+      break;
+    }
+    table->slots[i] = table->slots[j];
+    i = j;
+  }
+}
+
+void edgeTableFree(EdgeTable *table){
+  free(table->slots);
+  table->slots = NULL;
+  table->slotsCount = 0;
+  table->count = 0;
+}
+
+//CITY INDEX
+
+void cityIndexInit(CityIndex *index){
+  index->slots = NULL;
+  index->slotsCount = 0;
+  index->count = 0;
+}
+
+static uint32_t findCitySlot(const CitySlot *slots, uint32_t mask, uint32_t id){
+  uint32_t i = hashKey(id) & mask;
+  while(slots[i].key != 0 && slots[i].key != id + 1) i = (i + 1) & mask;
+  return i;
+}
+
+bool cityIndexReserve(CityIndex *index, uint32_t count){
+  // Współczynnik zapełnienia nie przekracza 1/2.
+  uint32_t needed = index->count + count;
+  if(2 * needed <= index->slotsCount) return true;
+
+  uint32_t newCount = index->slotsCount == 0 ? INITIAL_SLOTS : index->slotsCount;
+  while(newCount < 2 * needed) newCount *= 2;
+  CitySlot *newSlots = (CitySlot*)calloc(newCount, sizeof(CitySlot));
+  if(newSlots == NULL) return false;
+
+  for(uint32_t i = 0; i < index->slotsCount; i++){
+    if(index->slots[i].key != 0){
+      newSlots[findCitySlot(newSlots, newCount - 1, index->slots[i].key - 1)] = index->slots[i];
+    }
+  }
+
+  free(index->slots);
+  index->slots = newSlots;
+  index->slotsCount = newCount;
+  return true;
+}
+
+void cityIndexPut(CityIndex *index, uint32_t id, uint32_t value){
+  CitySlot *slot = &(index->slots[findCitySlot(index->slots, index->slotsCount - 1, id)]);
+  if(slot->key == 0){
+    slot->key = id + 1;
+    index->count++;
+  }
+  slot->value = value;
+}
+
+bool cityIndexFind(const CityIndex *index, uint32_t id, uint32_t *value){
+  if(index->count == 0) return false;
+  const CitySlot *slot = &(index->slots[findCitySlot(index->slots, index->slotsCount - 1, id)]);
+  if(slot->key == 0) return false;
+  *value = slot->value;
+  return true;
+}
+
+bool cityIndexHas(const CityIndex *index, uint32_t id){
+  if(index->count == 0) return false;
+  return index->slots[findCitySlot(index->slots, index->slotsCount - 1, id)].key != 0;
+}
+
+void cityIndexFree(CityIndex *index){
+  free(index->slots);
+  cityIndexInit(index);
+}
+
+//NAME SET
+
+void nameSetInit(NameSet *set){
+  set->slots = NULL;
+  set->slotsCount = 0;
+  set->count = 0;
+}
+
+static uint32_t findNameSlot(const char **slots, uint32_t mask, const char *name){
+  uint32_t i = hashName(name) & mask;
+  while(slots[i] != NULL && strcmp(slots[i], name) != 0) i = (i + 1) & mask;
+  return i;
+}
+
+bool nameSetReserve(NameSet *set, uint32_t count){
+  // Współczynnik zapełnienia nie przekracza 1/2.
+  uint32_t needed = set->count + count;
+  if(2 * needed <= set->slotsCount) return true;
+
+  uint32_t newCount = set->slotsCount == 0 ? INITIAL_SLOTS : set->slotsCount;
+  while(newCount < 2 * needed) newCount *= 2;
+  const char **newSlots = (const char**)calloc(newCount, sizeof(const char*));
+  if(newSlots == NULL) return false;
+
+  for(uint32_t i = 0; i < set->slotsCount; i++){
+    if(set->slots[i] != NULL) newSlots[findNameSlot(newSlots, newCount - 1, set->slots[i])] = set->slots[i];
+  }
+
+  free(set->slots);
+  set->slots = newSlots;
+  set->slotsCount = newCount;
+  return true;
+}
+
+void nameSetAdd(NameSet *set, const char *name){
+  set->slots[findNameSlot(set->slots, set->slotsCount - 1, name)] = name;
+  set->count++;
+}
+
+bool nameSetHas(const NameSet *set, const char *name){
+  if(set->count == 0) return false;
+  return set->slots[findNameSlot(set->slots, set->slotsCount - 1, name)] != NULL;
+}
+
+void nameSetFree(NameSet *set){
+  free(set->slots);
+  nameSetInit(set);
+}
@@ -0,0 +1,242 @@
+/** @file
+ * Tablice mieszające używane przez mapę dróg krajowych.
+ *
+ * @author Jakub Organa
+ * @date 17.10.2026
+ */
+
+#ifndef __HASH_H__
+#define __HASH_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include "types.h"
+
+/**
+ * Tablica miast: internuje nazwy miast i nadaje im kolejne identyfikatory.
+ * Miasto o identyfikatorze id znajduje się w cities[id]. Wyszukiwanie po nazwie
+ * odbywa się przez tablicę mieszającą z adresowaniem otwartym.
+ */
+typedef struct CityTable {
+  /*@{*/
+  City **cities; /**< tablica miast indeksowana identyfikatorami */
+  uint32_t count; /**< liczba miast */
+  uint32_t capacity; /**< rozmiar tablicy cities */
+  uint32_t *slots; /**< kubełki tablicy mieszającej (identyfikator + 1, lub 0 gdy pusty) */
+  uint32_t slotsCount; /**< liczba kubełków (potęga dwójki) */
+  /*@}*/
+} CityTable;
+
+/**
+ * Kubełek indeksu odcinków dróg.
+ */
+typedef struct EdgeSlot {
+  /*@{*/
+  uint64_t key; /**< para identyfikatorów miast (mniejszy w starszych bitach) */
+  Neigh *neigh; /**< odcinek skierowany od miasta o mniejszym identyfikatorze, lub NULL gdy kubełek jest pusty */
+  /*@}*/
+} EdgeSlot;
+
+/**
+ * Indeks odcinków dróg: tablica mieszająca z adresowaniem otwartym, w której
+ * kluczem jest nieuporządkowana para identyfikatorów miast.
+ */
+typedef struct EdgeTable {
+  /*@{*/
+  EdgeSlot *slots; /**< kubełki */
+  uint32_t slotsCount; /**< liczba kubełków (potęga dwójki) */
+  uint32_t count; /**< liczba odcinków */
+  /*@}*/
+} EdgeTable;
+
+/**
+ * Kubełek indeksu miast.
+ */
+typedef struct CitySlot {
+  /*@{*/
+  uint32_t key; /**< identyfikator miasta + 1, lub 0 gdy kubełek jest pusty */
+  uint32_t value; /**< wartość przypisana miastu */
+  /*@}*/
+} CitySlot;
+
+/**
+ * Indeks miast: tablica mieszająca z adresowaniem otwartym, przypisująca
+ * miastom (identyfikatorom) wartości. Miasta nie są z niego usuwane.
+ */
+typedef struct CityIndex {
+  /*@{*/
+  CitySlot *slots; /**< kubełki */
+  uint32_t slotsCount; /**< liczba kubełków (potęga dwójki lub 0) */
+  uint32_t count; /**< liczba miast w indeksie */
+  /*@}*/
+} CityIndex;
+
+/**
+ * Zbiór nazw: tablica mieszająca z adresowaniem otwartym, przechowująca
+ * wskaźniki na napisy, które nie są kopiowane. Nazwy nie są z niego usuwane.
+ */
+typedef struct NameSet {
+  /*@{*/
+  const char **slots; /**< kubełki (NULL gdy pusty) */
+  uint32_t slotsCount; /**< liczba kubełków (potęga dwójki lub 0) */
+  uint32_t count; /**< liczba nazw w zbiorze */
+  /*@}*/
+} NameSet;
+
+/** @brief Liczy wartość funkcji mieszającej dla nazwy miasta.
+ * @param[in] name      - nazwa miasta
+ * @return Zwraca wartość funkcji mieszającej.
+ */
+uint32_t hashName(const char *name);
+
+/** @brief Liczy wartość funkcji mieszającej dla liczby.
+ * @param[in] key      - liczba
+ * @return Zwraca wartość funkcji mieszającej.
+ */
+uint32_t hashKey(uint64_t key);
+
+/** @brief Inicjalizuje pustą tablicę miast.
+ * @param[out] table      - wskaźnik na tablicę
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool cityTableInit(CityTable *table);
+
+/** @brief Wyszukuje miasto o podanej nazwie.
+ * Nie alokuje pamięci.
+ * @param[in] table      - wskaźnik na tablicę
+ * @param[in] name      - nazwa miasta
+ * @return Zwraca wskaźnik na miasto, lub NULL jeśli miasto nie istnieje.
+ */
+City *cityTableFind(CityTable *table, const char *name);
+
+/** @brief Dodaje miasto do tablicy i nadaje mu kolejny identyfikator.
+ * Założenie: w tablicy nie ma miasta o tej samej nazwie.
+ * @param[in, out] table      - wskaźnik na tablicę
+ * @param[in, out] cityPtr      - wskaźnik na miasto
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool cityTableAdd(CityTable *table, City *cityPtr);
+
+/** @brief Usuwa z tablicy ostatnio dodane miasto (nie zwalniając go).
+ * Służy do wycofania dodania miasta, gdy dalsza część operacji się nie powiodła.
+ * @param[in, out] table      - wskaźnik na tablicę
+ */
+void cityTableRemoveLast(CityTable *table);
+
+/** @brief Zwalnia pamięć tablicy (same miasta należą do pul mapy).
+ * @param[in, out] table      - wskaźnik na tablicę
+ */
+void cityTableFree(CityTable *table);
+
+/** @brief Inicjalizuje pusty indeks odcinków dróg.
+ * @param[out] table      - wskaźnik na indeks
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool edgeTableInit(EdgeTable *table);
+
+/** @brief Wyszukuje odcinek drogi między dwoma miastami.
+ * Nie alokuje pamięci.
+ * @param[in] table      - wskaźnik na indeks
+ * @param[in] cityPtr1      - wskaźnik na pierwsze miasto
+ * @param[in] cityPtr2      - wskaźnik na drugie miasto
+ * @return Zwraca odcinek skierowany od cityPtr1 do cityPtr2, lub NULL jeśli takiego nie ma.
+ */
+Neigh *edgeTableFind(EdgeTable *table, City *cityPtr1, City *cityPtr2);
+
+/** @brief Dodaje odcinek drogi do indeksu.
+ * Założenie: pole reversed odcinka jest ustawione, a między miastami nie ma jeszcze odcinka.
+ * @param[in, out] table      - wskaźnik na indeks
+ * @param[in] neighPtr      - wskaźnik na jeden z dwóch skierowanych odcinków drogi
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool edgeTableAdd(EdgeTable *table, Neigh *neighPtr);
+
+/** @brief Usuwa odcinek drogi z indeksu.
+ * @param[in, out] table      - wskaźnik na indeks
+ * @param[in] neighPtr      - wskaźnik na jeden z dwóch skierowanych odcinków drogi
+ */
+void edgeTableRemove(EdgeTable *table, Neigh *neighPtr);
+
+/** @brief Zwalnia pamięć indeksu (nie usuwa samych odcinków).
+ * @param[in, out] table      - wskaźnik na indeks
+ */
+void edgeTableFree(EdgeTable *table);
+
+/** @brief Inicjalizuje pusty indeks miast.
+ * Nie alokuje pamięci.
+ * @param[out] index      - wskaźnik na indeks
+ */
+void cityIndexInit(CityIndex *index);
+
+/** @brief Zapewnia miejsce na podaną liczbę dodatkowych miast.
+ * Po powodzeniu tyle wywołań cityIndexPut nie alokuje już pamięci.
+ * @param[in, out] index      - wskaźnik na indeks
+ * @param[in] count      - liczba miast, które zostaną dodane
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool cityIndexReserve(CityIndex *index, uint32_t count);
+
+/** @brief Przypisuje miastu wartość, dodając je do indeksu, jeśli jeszcze w nim nie jest.
+ * Założenie: miejsce zostało zapewnione przez cityIndexReserve.
+ * @param[in, out] index      - wskaźnik na indeks
+ * @param[in] id      - identyfikator miasta
+ * @param[in] value      - wartość
+ */
+void cityIndexPut(CityIndex *index, uint32_t id, uint32_t value);
+
+/** @brief Wyszukuje wartość przypisaną miastu.
+ * @param[in] index      - wskaźnik na indeks
+ * @param[in] id      - identyfikator miasta
+ * @param[out] value      - tu zostanie zapisana wartość, jeśli miasto jest w indeksie
+ * @return Zwraca true jeśli miasto należy do indeksu, lub false w przeciwnym przypadku.
+ */
+bool cityIndexFind(const CityIndex *index, uint32_t id, uint32_t *value);
+
+/** @brief Sprawdza, czy miasto należy do indeksu.
+ * @param[in] index      - wskaźnik na indeks
+ * @param[in] id      - identyfikator miasta
+ * @return Zwraca true jeśli miasto należy do indeksu, lub false w przeciwnym przypadku.
+ */
+bool cityIndexHas(const CityIndex *index, uint32_t id);
+
+/** @brief Zwalnia pamięć indeksu, pozostawiając go pustym.
+ * @param[in, out] index      - wskaźnik na indeks
+ */
+void cityIndexFree(CityIndex *index);
+
+/** @brief Inicjalizuje pusty zbiór nazw.
+ * Nie alokuje pamięci.
+ * @param[out] set      - wskaźnik na zbiór
+ */
+void nameSetInit(NameSet *set);
+
+/** @brief Zapewnia w zbiorze miejsce na podaną liczbę kolejnych nazw.
+ * @param[in, out] set      - wskaźnik na zbiór
+ * @param[in] count      - liczba nazw
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool nameSetReserve(NameSet *set, uint32_t count);
+
+/** @brief Dodaje nazwę do zbioru.
+ * Założenie: miejsce zostało zapewnione przez nameSetReserve, a nazwy nie ma
+ * w zbiorze. Napis musi istnieć tak długo jak zbiór.
+ * @param[in, out] set      - wskaźnik na zbiór
+ * @param[in] name      - nazwa
+ */
+void nameSetAdd(NameSet *set, const char *name);
+
+/** @brief Sprawdza, czy nazwa należy do zbioru.
+ * @param[in] set      - wskaźnik na zbiór
+ * @param[in] name      - nazwa
+ * @return Zwraca true jeśli nazwa należy do zbioru, lub false w przeciwnym przypadku.
+ */
+bool nameSetHas(const NameSet *set, const char *name);
+
+/** @brief Zwalnia pamięć zbioru, pozostawiając go pustym.
+ * @param[in, out] set      - wskaźnik na zbiór
+ */
+void nameSetFree(NameSet *set);
+
+#endif /* __HASH_H__ */
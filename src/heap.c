@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "heap.h"
+
+static const uint32_t ARITY = 4;
+
+static void bucketInit(QueueBucket *bucket){
+  bucket->entries = NULL;
+  bucket->size = 0;
+  bucket->capacity = 0;
+}
+
+static bool bucketPush(QueueBucket *bucket, QueueEntry entry){
+  if(bucket->size == bucket->capacity){
+    uint32_t newCapacity = bucket->capacity == 0 ? 16 : 2 * bucket->capacity;
+    QueueEntry *newEntries = (QueueEntry*)realloc(bucket->entries, newCapacity * sizeof(QueueEntry));
+    if(newEntries == NULL) return false;
+    bucket->entries = newEntries;
+    bucket->capacity = newCapacity;
+  }
+  bucket->entries[bucket->size] = entry;
+  bucket->size++;
+  return true;
+}
+
+void pqInit(PQueue *queue, QueueKind kind){
+  queue->kind = kind;
+  bucketInit(&(queue->heap));
+  for(int32_t i = 0; i < QUEUE_BUCKETS; i++) bucketInit(&(queue->buckets[i]));
+  queue->last = 0;
+  queue->count = 0;
+}
+
+void pqSetKind(PQueue *queue, QueueKind kind){
+  pqClear(queue);
+  queue->kind = kind;
+}
+
+bool pqEmpty(PQueue *queue){
+  return queue->count == 0;
+}
+
+void pqClear(PQueue *queue){
+  queue->heap.size = 0;
+  for(int32_t i = 0; i < QUEUE_BUCKETS; i++) queue->buckets[i].size = 0;
+  queue->last = 0;
+  queue->count = 0;
+}
+
+void pqFree(PQueue *queue){
+  free(queue->heap.entries);
+  bucketInit(&(queue->heap));
+  for(int32_t i = 0; i < QUEUE_BUCKETS; i++){
+    free(queue->buckets[i].entries);
+    bucketInit(&(queue->buckets[i]));
+  }
+  queue->count = 0;
+}
+
+static bool entryLess(QueueEntry *a, QueueEntry *b){
+  if(a->key != b->key) return a->key < b->key;
+  return a->tie < b->tie;
+}
+
+//HEAP
+
+static bool heapPush(QueueBucket *heap, QueueEntry entry){
+  if(!bucketPush(heap, entry)) return false;
+
+  QueueEntry *entries = heap->entries;
+  uint32_t i = heap->size - 1;
+  while(i > 0){
+    uint32_t parent = (i - 1) / ARITY;
+    if(!entryLess(&entry, &(entries[parent]))) break;
+    entries[i] = entries[parent];
+    i = parent;
+  }
+  entries[i] = entry;
+  return true;
+}
+
+static QueueEntry heapPop(QueueBucket *heap){
+  QueueEntry *entries = heap->entries;
+  QueueEntry result = entries[0];
+  heap->size--;
+  if(heap->size == 0) return result;
+
+  QueueEntry moved = entries[heap->size];
+  uint32_t i = 0;
+  while(true){
+    uint32_t first = ARITY * i + 1;
+    if(first >= heap->size) break;
+
+    uint32_t last = first + ARITY;
+    if(last > heap->size) last = heap->size;
+    uint32_t best = first;
+    for(uint32_t c = first + 1; c < last; c++){
+      if(entryLess(&(entries[c]), &(entries[best]))) best = c;
+    }
+
+    if(!entryLess(&(entries[best]), &moved)) break;
+    entries[i] = entries[best];
+    i = best;
+  }
+  entries[i] = moved;
+  return result;
+}
+
+//RADIX
+
+static int32_t radixBucket(uint64_t key, uint64_t last){
+  if(key == last) return 0;
+  return 64 - __builtin_clzll(key ^ last);
+}
+
+// Kubełek 0 zawiera elementy o kluczu równym last, ułożone w kopiec według
+// tie, więc zdejmowanie z niego kosztuje O(log n) nawet przy wielu równych
+// kluczach.
+static bool radixPushTo(PQueue *queue, int32_t i, QueueEntry entry){
+  if(i == 0) return heapPush(&(queue->buckets[0]), entry);
+  return bucketPush(&(queue->buckets[i]), entry);
+}
+
+// Zapewnia, że kubełek 0 nie jest pusty.
+static bool radixPrepare(PQueue *queue){
+  if(queue->buckets[0].size > 0) return true;
+
+  int32_t i = 1;
+  while(queue->buckets[i].size == 0) i++;
+
+  // Najmniejszy klucz kubełka i staje się nowym punktem odniesienia,
+  // a pozostałe elementy kubełka trafiają do kubełków o mniejszych numerach.
+  QueueBucket *bucket = &(queue->buckets[i]);
+  uint64_t newLast = bucket->entries[0].key;
+  for(uint32_t j = 1; j < bucket->size; j++){
+    if(bucket->entries[j].key < newLast) newLast = bucket->entries[j].key;
+  }
+
+  while(bucket->size > 0){
+    QueueEntry moved = bucket->entries[bucket->size - 1];
+    if(!radixPushTo(queue, radixBucket(moved.key, newLast), moved)) return false;
+    bucket->size--;
+  }
+  queue->last = newLast;
+  return true;
+}
+
+static bool radixPush(PQueue *queue, QueueEntry entry){
+  return radixPushTo(queue, radixBucket(entry.key, queue->last), entry);
+}
+
+bool pqPush(PQueue *queue, uint64_t key, uint64_t tie, uint32_t item){
+  QueueEntry entry;
+  entry.key = key;
+  entry.tie = tie;
+  entry.item = item;
+
+  bool pushed = false;
+  if(queue->kind == QUEUE_HEAP) pushed = heapPush(&(queue->heap), entry);
+  else pushed = radixPush(queue, entry);
+
+  if(pushed) queue->count++;
+  return pushed;
+}
+
+bool pqTop(PQueue *queue, QueueEntry *entry){
+  if(queue->kind == QUEUE_HEAP){
+    *entry = queue->heap.entries[0];
+    return true;
+  }
+
+  if(!radixPrepare(queue)) return false;
+  *entry = queue->buckets[0].entries[0];
+  return true;
+}
+
+bool pqPop(PQueue *queue, QueueEntry *entry){
+  if(queue->kind == QUEUE_HEAP){
+    *entry = heapPop(&(queue->heap));
+  } else {
+    if(!radixPrepare(queue)) return false;
+    *entry = heapPop(&(queue->buckets[0]));
+  }
+
+  queue->count--;
+  return true;
+}
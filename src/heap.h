@@ -0,0 +1,120 @@
+/** @file
+ * Kolejki priorytetowe dla algorytmu Dijkstry: kopiec czwórkowy oraz kopiec
+ * pozycyjny (radix heap) dla monotonicznych kluczy całkowitych.
+ *
+ * @author Jakub Organa
+ * @date 17.10.2026
+ */
+
+#ifndef __HEAP_H__
+#define __HEAP_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdbool.h>
+
+/**
+ * Rodzaj kolejki priorytetowej.
+ */
+typedef enum QueueKind {
+  QUEUE_HEAP, /**< kopiec czwórkowy */
+  QUEUE_RADIX /**< kopiec pozycyjny; klucze wstawiane nie mogą być mniejsze od ostatnio zdjętego */
+} QueueKind;
+
+/**
+ * Element kolejki priorytetowej.
+ */
+typedef struct QueueEntry {
+  /*@{*/
+  uint64_t key; /**< klucz */
+  uint64_t tie; /**< drugorzędny klucz, rozstrzygający przy równych kluczach */
+  uint32_t item; /**< identyfikator elementu (miasta) */
+  /*@}*/
+} QueueEntry;
+
+/**
+ * Kubełek kopca pozycyjnego.
+ */
+typedef struct QueueBucket {
+  /*@{*/
+  QueueEntry *entries; /**< elementy kubełka */
+  uint32_t size; /**< liczba elementów */
+  uint32_t capacity; /**< rozmiar tablicy entries */
+  /*@}*/
+} QueueBucket;
+
+/** Liczba kubełków kopca pozycyjnego (klucze 64-bitowe). */
+#define QUEUE_BUCKETS 65
+
+/**
+ * Kolejka priorytetowa. Pamięć jest zachowywana między kolejnymi
+ * wyszukiwaniami, więc w stanie ustalonym operacje nie alokują pamięci.
+ */
+typedef struct PQueue {
+  /*@{*/
+  QueueKind kind; /**< rodzaj kolejki */
+  QueueBucket heap; /**< tablica kopca czwórkowego */
+  QueueBucket buckets[QUEUE_BUCKETS]; /**< kubełki kopca pozycyjnego */
+  uint64_t last; /**< ostatnio zdjęty klucz kopca pozycyjnego */
+  uint32_t count; /**< liczba elementów kolejki */
+  /*@}*/
+} PQueue;
+
+/** @brief Inicjalizuje pustą kolejkę.
+ * @param[out] queue      - wskaźnik na kolejkę
+ * @param[in] kind      - rodzaj kolejki
+ */
+void pqInit(PQueue *queue, QueueKind kind);
+
+/** @brief Zmienia rodzaj kolejki. Kolejka zostaje opróżniona.
+ * @param[in, out] queue      - wskaźnik na kolejkę
+ * @param[in] kind      - rodzaj kolejki
+ */
+void pqSetKind(PQueue *queue, QueueKind kind);
+
+/** @brief Sprawdza, czy kolejka jest pusta.
+ * @param[in] queue      - wskaźnik na kolejkę
+ * @return Zwraca true, jeśli kolejka jest pusta.
+ */
+bool pqEmpty(PQueue *queue);
+
+/** @brief Wstawia element do kolejki.
+ * @param[in, out] queue      - wskaźnik na kolejkę
+ * @param[in] key      - klucz
+ * @param[in] tie      - drugorzędny klucz
+ * @param[in] item      - identyfikator elementu
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool pqPush(PQueue *queue, uint64_t key, uint64_t tie, uint32_t item);
+
+/** @brief Podaje element o najmniejszym kluczu, nie zdejmując go z kolejki.
+ * Założenie: kolejka nie jest pusta.
+ * @param[in, out] queue      - wskaźnik na kolejkę
+ * @param[out] entry      - element o najmniejszym kluczu
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci
+ * (kopiec pozycyjny przenosi elementy między kubełkami).
+ */
+bool pqTop(PQueue *queue, QueueEntry *entry);
+
+/** @brief Zdejmuje z kolejki element o najmniejszym kluczu (przy równych
+ * kluczach – o najmniejszym kluczu drugorzędnym).
+ * Założenie: kolejka nie jest pusta.
+ * @param[in, out] queue      - wskaźnik na kolejkę
+ * @param[out] entry      - zdjęty element
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci
+ * (kopiec pozycyjny przenosi elementy między kubełkami).
+ */
+bool pqPop(PQueue *queue, QueueEntry *entry);
+
+/** @brief Opróżnia kolejkę, zachowując zaalokowaną pamięć.
+ * @param[in, out] queue      - wskaźnik na kolejkę
+ */
+void pqClear(PQueue *queue);
+
+/** @brief Zwalnia pamięć kolejki.
+ * @param[in, out] queue      - wskaźnik na kolejkę
+ */
+void pqFree(PQueue *queue);
+
+#endif /* __HEAP_H__ */
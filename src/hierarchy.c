@@ -0,0 +1,451 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "types.h"
+#include "heap.h"
+#include "graph.h"
+#include "hierarchy.h"
+
+static const uint64_t INFINITY = 9223372036854775807;
+
+/** Liczba miast, które może ustalić wyszukiwanie świadka, zanim uznamy, że
+ * skrót jest potrzebny. */
+static const uint32_t WITNESS_LIMIT = 128;
+
+/** Przesunięcie priorytetów ściągania, które mogą być ujemne. */
+static const int64_t PRIORITY_OFFSET = 2147483648;
+
+/**
+ * Stan roboczy budowy hierarchii. Listy adj zawierają krawędzie prowadzące do
+ * miast jeszcze nieściągniętych; lista ściąganego miasta zostaje zachowana
+ * i staje się jego wierszem w grafie up.
+ */
+typedef struct Builder {
+  /*@{*/
+  uint32_t rows; /**< liczba miast */
+  uint32_t **adj; /**< krawędzie incydentne z miastami */
+  uint32_t *adjSize; /**< długości list adj */
+  uint32_t *adjCapacity; /**< rozmiary tablic list adj */
+  bool *contracted; /**< informacja, czy miasto zostało już ściągnięte */
+  uint32_t *deleted; /**< liczba ściągniętych sąsiadów miasta */
+  uint32_t *seen; /**< numer wyszukiwania świadka, w którym miasto zostało osiągnięte */
+  uint64_t *dist; /**< odległości w wyszukiwaniu świadka */
+  uint32_t *nearSeen; /**< numer przetwarzania, w którym policzono nearLength miasta */
+  uint32_t *nearLength; /**< najkrótsza krawędź od przetwarzanego miasta do sąsiada */
+  uint32_t epoch; /**< numer wyszukiwania świadka */
+  uint32_t nearEpoch; /**< numer przetwarzania miasta */
+  uint32_t arcsLimit; /**< liczba krawędzi, po przekroczeniu której budowa jest przerywana */
+  PQueue queue; /**< kolejka wyszukiwania świadka */
+  /*@}*/
+} Builder;
+
+void hierarchyInit(Hierarchy *hierarchy){
+  hierarchy->enabled = false;
+  hierarchy->built = false;
+  hierarchy->ready = false;
+  hierarchy->stale = true;
+  hierarchy->yearsStale = false;
+  hierarchy->buildCost = 0;
+  hierarchy->staleCost = 0;
+  hierarchy->searchStart = 0;
+  hierarchy->arcs = NULL;
+  hierarchy->arcsCount = 0;
+  hierarchy->arcsCapacity = 0;
+  graphInit(&(hierarchy->up));
+  hierarchy->upArcs = NULL;
+}
+
+void hierarchyFree(Hierarchy *hierarchy){
+  bool enabled = hierarchy->enabled;
+  bool built = hierarchy->built;
+  free(hierarchy->arcs);
+  graphFree(&(hierarchy->up));
+  free(hierarchy->upArcs);
+  hierarchyInit(hierarchy);
+  hierarchy->enabled = enabled;
+  hierarchy->built = built;
+}
+
+void hierarchyInvalidate(Hierarchy *hierarchy){
+  hierarchy->stale = true;
+  hierarchy->staleCost = 0;
+}
+
+static uint32_t otherEnd(HierarchyArc *arc, uint32_t id){
+  return arc->from == id ? arc->to : arc->from;
+}
+
+static bool addArc(Hierarchy *hierarchy, HierarchyArc arc, uint32_t *id){
+  if(hierarchy->arcsCount == hierarchy->arcsCapacity){
+    uint32_t capacity = hierarchy->arcsCapacity == 0 ? 64 : 2 * hierarchy->arcsCapacity;
+    HierarchyArc *arcs = (HierarchyArc*)realloc(hierarchy->arcs, capacity * sizeof(HierarchyArc));
+    if(arcs == NULL) return false;
+    hierarchy->arcs = arcs;
+    hierarchy->arcsCapacity = capacity;
+  }
+  *id = hierarchy->arcsCount;
+  hierarchy->arcs[*id] = arc;
+  hierarchy->arcsCount++;
+  return true;
+}
+
+static bool adjPush(Builder *builder, uint32_t id, uint32_t arc){
+  if(builder->adjSize[id] == builder->adjCapacity[id]){
+    uint32_t capacity = builder->adjCapacity[id] == 0 ? 4 : 2 * builder->adjCapacity[id];
+    uint32_t *list = (uint32_t*)realloc(builder->adj[id], capacity * sizeof(uint32_t));
+    if(list == NULL) return false;
+    builder->adj[id] = list;
+    builder->adjCapacity[id] = capacity;
+  }
+  builder->adj[id][builder->adjSize[id]] = arc;
+  builder->adjSize[id]++;
+  return true;
+}
+
+static void builderFree(Builder *builder){
+  if(builder->adj != NULL){
+    for(uint32_t id = 0; id < builder->rows; id++) free(builder->adj[id]);
+  }
+  free(builder->adj);
+  free(builder->adjSize);
+  free(builder->adjCapacity);
+  free(builder->contracted);
+  free(builder->deleted);
+  free(builder->seen);
+  free(builder->dist);
+  free(builder->nearSeen);
+  free(builder->nearLength);
+  pqFree(&(builder->queue));
+}
+
+static bool builderInit(Builder *builder, uint32_t rows){
+  uint32_t count = rows == 0 ? 1 : rows;
+  builder->rows = rows;
+  builder->adj = (uint32_t**)calloc(count, sizeof(uint32_t*));
+  builder->adjSize = (uint32_t*)calloc(count, sizeof(uint32_t));
+  builder->adjCapacity = (uint32_t*)calloc(count, sizeof(uint32_t));
+  builder->contracted = (bool*)calloc(count, sizeof(bool));
+  builder->deleted = (uint32_t*)calloc(count, sizeof(uint32_t));
+  builder->seen = (uint32_t*)calloc(count, sizeof(uint32_t));
+  builder->dist = (uint64_t*)malloc(count * sizeof(uint64_t));
+  builder->nearSeen = (uint32_t*)calloc(count, sizeof(uint32_t));
+  builder->nearLength = (uint32_t*)malloc(count * sizeof(uint32_t));
+  builder->epoch = 0;
+  builder->nearEpoch = 0;
+  builder->arcsLimit = 0;
+  pqInit(&(builder->queue), QUEUE_HEAP);
+
+  return builder->adj != NULL && builder->adjSize != NULL && builder->adjCapacity != NULL
+      && builder->contracted != NULL && builder->deleted != NULL && builder->seen != NULL
+      && builder->dist != NULL && builder->nearSeen != NULL && builder->nearLength != NULL;
+}
+
+static uint32_t nextEpoch(uint32_t *epoch, uint32_t *stamps, uint32_t rows){
+  (*epoch)++;
+  if(*epoch == 0){
+    for(uint32_t id = 0; id < rows; id++) stamps[id] = 0;
+    *epoch = 1;
+  }
+  return *epoch;
+}
+
+// Wyszukuje od miasta source, z pominięciem miasta avoid, ścieżki nie dłuższe
+// niż maxDist. Przerwane wcześniej wyszukiwanie może jedynie zawyżyć
+// odległości, co skutkuje dodaniem zbędnego skrótu.
+static bool witnessSearch(Builder *builder, Hierarchy *hierarchy, uint32_t source, uint32_t avoid, uint64_t maxDist){
+  uint32_t epoch = nextEpoch(&(builder->epoch), builder->seen, builder->rows);
+  PQueue *queue = &(builder->queue);
+
+  builder->seen[source] = epoch;
+  builder->dist[source] = 0;
+  bool ok = pqPush(queue, 0, 0, source);
+
+  uint32_t settledCount = 0;
+  while(ok && !pqEmpty(queue)){
+    QueueEntry nearest;
+    if(!pqPop(queue, &nearest)){
+      ok = false;
+      break;
+    }
+    uint32_t id = nearest.item;
+    if(nearest.key > builder->dist[id]) continue;
+    if(nearest.key > maxDist || settledCount == WITNESS_LIMIT) break;
+    settledCount++;
+
+    for(uint32_t i = 0; i < builder->adjSize[id] && ok; i++){
+      HierarchyArc *arc = &(hierarchy->arcs[builder->adj[id][i]]);
+      uint32_t dest = otherEnd(arc, id);
+      if(dest == avoid) continue;
+
+      uint64_t potDist = nearest.key + arc->length;
+      if(builder->seen[dest] == epoch && builder->dist[dest] <= potDist) continue;
+      builder->seen[dest] = epoch;
+      builder->dist[dest] = potDist;
+      ok = pqPush(queue, potDist, 0, dest);
+    }
+  }
+  pqClear(queue);
+  return ok;
+}
+
+static uint64_t witnessDist(Builder *builder, uint32_t id){
+  if(builder->seen[id] != builder->epoch) return INFINITY;
+  return builder->dist[id];
+}
+
+static bool addShortcut(Builder *builder, Hierarchy *hierarchy, uint32_t middle, uint32_t first, uint32_t second){
+  HierarchyArc arc;
+  arc.from = otherEnd(&(hierarchy->arcs[first]), middle);
+  arc.to = otherEnd(&(hierarchy->arcs[second]), middle);
+  arc.length = hierarchy->arcs[first].length + hierarchy->arcs[second].length;
+  arc.year = min(hierarchy->arcs[first].year, hierarchy->arcs[second].year);
+  arc.neigh = NULL;
+  arc.middle = middle;
+  arc.first = first;
+  arc.second = second;
+
+  uint32_t id;
+  if(!addArc(hierarchy, arc, &id)) return false;
+  return adjPush(builder, arc.from, id) && adjPush(builder, arc.to, id);
+}
+
+// Wyznacza skróty potrzebne po ściągnięciu miasta id: dla każdej pary
+// najkrótszych krawędzi do różnych sąsiadów skrót jest zbędny tylko wtedy,
+// gdy między sąsiadami istnieje ścieżka ściśle krótsza. Jeśli apply jest
+// równe false, skróty są jedynie liczone.
+static bool processCity(Builder *builder, Hierarchy *hierarchy, uint32_t id, bool apply, uint32_t *shortcuts){
+  uint32_t *adj = builder->adj[id];
+  uint32_t size = builder->adjSize[id];
+  uint32_t nearEpoch = nextEpoch(&(builder->nearEpoch), builder->nearSeen, builder->rows);
+  *shortcuts = 0;
+
+  for(uint32_t i = 0; i < size; i++){
+    HierarchyArc *arc = &(hierarchy->arcs[adj[i]]);
+    uint32_t dest = otherEnd(arc, id);
+    if(builder->nearSeen[dest] != nearEpoch || arc->length < builder->nearLength[dest]){
+      builder->nearSeen[dest] = nearEpoch;
+      builder->nearLength[dest] = arc->length;
+    }
+  }
+
+  for(uint32_t i = 0; i < size; i++){
+    uint32_t length1 = hierarchy->arcs[adj[i]].length;
+    uint32_t source = otherEnd(&(hierarchy->arcs[adj[i]]), id);
+    if(length1 != builder->nearLength[source]) continue;
+
+    uint64_t maxDist = 0;
+    for(uint32_t j = i + 1; j < size; j++){
+      HierarchyArc *arc = &(hierarchy->arcs[adj[j]]);
+      uint32_t dest = otherEnd(arc, id);
+      if(dest == source || arc->length != builder->nearLength[dest]) continue;
+      if(length1 + (uint64_t)arc->length > maxDist) maxDist = length1 + (uint64_t)arc->length;
+    }
+    if(maxDist == 0) continue;
+    if(!witnessSearch(builder, hierarchy, source, id, maxDist)) return false;
+
+    for(uint32_t j = i + 1; j < size; j++){
+      HierarchyArc *arc = &(hierarchy->arcs[adj[j]]);
+      uint32_t dest = otherEnd(arc, id);
+      if(dest == source || arc->length != builder->nearLength[dest]) continue;
+      if(witnessDist(builder, dest) < length1 + (uint64_t)arc->length) continue;
+
+      (*shortcuts)++;
+      if(apply && !addShortcut(builder, hierarchy, id, adj[i], adj[j])) return false;
+    }
+  }
+  return true;
+}
+
+static bool cityPriority(Builder *builder, Hierarchy *hierarchy, uint32_t id, uint64_t *priority){
+  uint32_t shortcuts;
+  if(!processCity(builder, hierarchy, id, false, &shortcuts)) return false;
+  *priority = (uint64_t)(PRIORITY_OFFSET + 2 * (int64_t)shortcuts - builder->adjSize[id] + builder->deleted[id]);
+  return true;
+}
+
+static bool contractCity(Builder *builder, Hierarchy *hierarchy, uint32_t id){
+  uint32_t shortcuts;
+  if(!processCity(builder, hierarchy, id, true, &shortcuts)) return false;
+  builder->contracted[id] = true;
+
+  for(uint32_t i = 0; i < builder->adjSize[id]; i++){
+    uint32_t dest = otherEnd(&(hierarchy->arcs[builder->adj[id][i]]), id);
+    uint32_t *list = builder->adj[dest];
+    uint32_t kept = 0;
+    for(uint32_t j = 0; j < builder->adjSize[dest]; j++){
+      if(otherEnd(&(hierarchy->arcs[list[j]]), dest) != id) list[kept++] = list[j];
+    }
+    if(kept != builder->adjSize[dest]) builder->deleted[dest]++;
+    builder->adjSize[dest] = kept;
+  }
+  return true;
+}
+
+// Ściąga miasta w kolejności rosnącego priorytetu (liczba skrótów względem
+// stopnia), aktualizowanego leniwie przy zdejmowaniu z kolejki.
+static bool contractAll(Builder *builder, Hierarchy *hierarchy, bool *completed){
+  PQueue order;
+  pqInit(&order, QUEUE_HEAP);
+  bool ok = true;
+  *completed = true;
+
+  for(uint32_t id = 0; id < builder->rows && ok; id++){
+    uint64_t priority;
+    ok = cityPriority(builder, hierarchy, id, &priority) && pqPush(&order, priority, id, id);
+  }
+
+  while(ok && !pqEmpty(&order)){
+    QueueEntry entry;
+    uint64_t priority;
+    if(!pqPop(&order, &entry) || !cityPriority(builder, hierarchy, entry.item, &priority)){
+      ok = false;
+      break;
+    }
+
+    QueueEntry next;
+    if(!pqEmpty(&order)){
+      if(!pqTop(&order, &next)){
+        ok = false;
+        break;
+      }
+      if(priority > next.key){
+        ok = pqPush(&order, priority, entry.item, entry.item);
+        continue;
+      }
+    }
+
+    ok = contractCity(builder, hierarchy, entry.item);
+    if(hierarchy->arcsCount > builder->arcsLimit){
+      *completed = false;
+      break;
+    }
+  }
+  pqFree(&order);
+  return ok;
+}
+
+static bool buildUp(Builder *builder, Hierarchy *hierarchy){
+  Graph *up = &(hierarchy->up);
+  uint32_t rows = builder->rows;
+  uint32_t total = 0;
+  for(uint32_t id = 0; id < rows; id++) total += builder->adjSize[id];
+  uint32_t slots = total == 0 ? 1 : total;
+
+  up->rowStart = (uint32_t*)malloc((rows + 1) * sizeof(uint32_t));
+  up->rowSize = (uint32_t*)malloc((rows + 1) * sizeof(uint32_t));
+  up->targets = (uint32_t*)malloc(slots * sizeof(uint32_t));
+  up->lengths = (uint32_t*)malloc(slots * sizeof(uint32_t));
+  up->years = (int32_t*)malloc(slots * sizeof(int32_t));
+  hierarchy->upArcs = (uint32_t*)malloc(slots * sizeof(uint32_t));
+  if(up->rowStart == NULL || up->rowSize == NULL || up->targets == NULL || up->lengths == NULL
+      || up->years == NULL || hierarchy->upArcs == NULL){
+    return false;
+  }
+
+  uint32_t k = 0;
+  for(uint32_t id = 0; id < rows; id++){
+    up->rowStart[id] = k;
+    up->rowSize[id] = builder->adjSize[id];
+    for(uint32_t i = 0; i < builder->adjSize[id]; i++){
+      HierarchyArc *arc = &(hierarchy->arcs[builder->adj[id][i]]);
+      up->targets[k] = otherEnd(arc, id);
+      up->lengths[k] = arc->length;
+      hierarchy->upArcs[k] = builder->adj[id][i];
+      k++;
+    }
+  }
+  up->rowStart[rows] = k;
+  up->rows = rows;
+  up->dirty = false;
+  return true;
+}
+
+bool hierarchyBuild(Hierarchy *hierarchy, Graph *graph){
+  clock_t start = clock();
+  hierarchyFree(hierarchy);
+
+  Builder builder;
+  bool ok = builderInit(&builder, graph->rows);
+
+  for(uint32_t from = 0; from < graph->rows && ok; from++){
+    uint32_t end = graph->rowStart[from] + graph->rowSize[from];
+    for(uint32_t k = graph->rowStart[from]; k < end && ok; k++){
+      if(graph->targets[k] < from) continue;
+
+      HierarchyArc arc;
+      arc.from = from;
+      arc.to = graph->targets[k];
+      arc.length = graph->lengths[k];
+      arc.year = graph->years[k];
+      arc.neigh = graph->edges[k];
+      arc.middle = 0;
+      arc.first = 0;
+      arc.second = 0;
+
+      uint32_t id;
+      ok = addArc(hierarchy, arc, &id) && adjPush(&builder, arc.from, id) && adjPush(&builder, arc.to, id);
+    }
+  }
+
+  // Przy złej kolejności ściągania (np. w gęstych siatkach odcinków równej
+  // długości) skrótów może być bardzo dużo; wtedy rezygnujemy z hierarchii.
+  builder.arcsLimit = 8 * hierarchy->arcsCount + 1024;
+  bool completed = false;
+  if(ok) ok = contractAll(&builder, hierarchy, &completed);
+  if(ok && completed) ok = buildUp(&builder, hierarchy);
+  builderFree(&builder);
+
+  if(!ok){
+    hierarchyFree(hierarchy);
+    hierarchy->buildCost = clock() - start;
+    return false;
+  }
+  if(!completed) hierarchyFree(hierarchy);
+
+  hierarchy->built = true;
+  hierarchy->ready = completed;
+  hierarchy->stale = false;
+  hierarchy->buildCost = clock() - start;
+  hierarchy->yearsStale = completed;
+  hierarchyUpdateYears(hierarchy);
+  return true;
+}
+
+void hierarchyUpdateYears(Hierarchy *hierarchy){
+  if(!hierarchy->yearsStale) return;
+
+  // Skrót jest tworzony po swoich składowych, więc wystarczy jedno przejście.
+  for(uint32_t i = 0; i < hierarchy->arcsCount; i++){
+    HierarchyArc *arc = &(hierarchy->arcs[i]);
+    if(arc->neigh != NULL) arc->year = arc->neigh->date;
+    else arc->year = min(hierarchy->arcs[arc->first].year, hierarchy->arcs[arc->second].year);
+  }
+
+  Graph *up = &(hierarchy->up);
+  for(uint32_t k = 0; k < up->rowStart[up->rows]; k++){
+    up->years[k] = hierarchy->arcs[hierarchy->upArcs[k]].year;
+  }
+  hierarchy->yearsStale = false;
+}
+
+bool hierarchyUnpack(Hierarchy *hierarchy, uint32_t arc, uint32_t fromId, Pools *pools, ListNode ***tail){
+  HierarchyArc *arcPtr = &(hierarchy->arcs[arc]);
+
+  if(arcPtr->neigh != NULL){
+    Neigh *neighPtr = arcPtr->from == fromId ? arcPtr->neigh : arcPtr->neigh->reversed;
+    ListNode *newListNode = createListNode(pools, neighPtr);
+    if(newListNode == NULL) return false;
+
+    **tail = newListNode;
+    *tail = &(newListNode->next);
+    return true;
+  }
+
+  if(arcPtr->from == fromId){
+    return hierarchyUnpack(hierarchy, arcPtr->first, fromId, pools, tail)
+        && hierarchyUnpack(hierarchy, arcPtr->second, arcPtr->middle, pools, tail);
+  }
+  return hierarchyUnpack(hierarchy, arcPtr->second, fromId, pools, tail)
+      && hierarchyUnpack(hierarchy, arcPtr->first, arcPtr->middle, pools, tail);
+}
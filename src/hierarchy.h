@@ -0,0 +1,109 @@
+/** @file
+ * Hierarchia kontrakcyjna (contraction hierarchy) sieci dróg, przyspieszająca
+ * wielokrotne wyszukiwanie ścieżek na rzadko zmienianej mapie.
+ *
+ * @author Jakub Organa
+ * @date 17.10.2026
+ */
+
+#ifndef __HIERARCHY_H__
+#define __HIERARCHY_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <time.h>
+#include "types.h"
+#include "heap.h"
+#include "graph.h"
+
+/**
+ * Krawędź hierarchii: odcinek drogi albo skrót zastępujący dwie krawędzie
+ * przechodzące przez ściągnięte miasto. Krawędzie są nieskierowane.
+ */
+typedef struct HierarchyArc {
+  /*@{*/
+  uint32_t from; /**< identyfikator pierwszego końca */
+  uint32_t to; /**< identyfikator drugiego końca */
+  uint32_t length; /**< długość */
+  int32_t year; /**< najstarszy rok budowy lub remontu wśród zastępowanych odcinków */
+  Neigh *neigh; /**< odcinek skierowany od from do to, lub NULL dla skrótu */
+  uint32_t middle; /**< ściągnięte miasto, przez które prowadzi skrót */
+  uint32_t first; /**< krawędź skrótu między from i middle */
+  uint32_t second; /**< krawędź skrótu między middle i to */
+  /*@}*/
+} HierarchyArc;
+
+/**
+ * Hierarchia kontrakcyjna. Miasta są ściągane kolejno, a dla każdej pary
+ * sąsiadów ściąganego miasta dodawany jest skrót, chyba że istnieje między
+ * nimi ścieżka ściśle krótsza. Skróty są dodawane także przy ścieżkach równej
+ * długości, więc każda najkrótsza ścieżka sieci ma w hierarchii swój
+ * odpowiednik; dzięki temu wyszukiwanie wykrywa niejednoznaczność wyboru.
+ *
+ * Skróty zależą tylko od długości odcinków, więc po remoncie wystarczy
+ * przeliczyć lata. Dodanie lub usunięcie odcinka czyni hierarchię
+ * nieaktualną.
+ */
+typedef struct Hierarchy {
+  /*@{*/
+  bool enabled; /**< informacja, czy mapa ma używać hierarchii */
+  bool built; /**< informacja, czy hierarchia była już budowana */
+  bool ready; /**< informacja, czy hierarchia jest zbudowana i może być używana */
+  bool stale; /**< informacja, czy hierarchia wymaga przebudowy */
+  bool yearsStale; /**< informacja, czy lata krawędzi wymagają przeliczenia */
+  clock_t buildCost; /**< czas procesora zużyty na ostatnią budowę */
+  clock_t staleCost; /**< czas procesora wyszukiwań wykonanych bez hierarchii od ostatniej zmiany sieci */
+  clock_t searchStart; /**< chwila rozpoczęcia ostatniego wyszukiwania bez hierarchii */
+  HierarchyArc *arcs; /**< krawędzie w kolejności tworzenia (skrót po swoich składowych) */
+  uint32_t arcsCount; /**< liczba krawędzi */
+  uint32_t arcsCapacity; /**< rozmiar tablicy arcs */
+  Graph up; /**< krawędzie prowadzące do miast ściągniętych później (pole edges nieużywane) */
+  uint32_t *upArcs; /**< krawędzie hierarchii odpowiadające pozycjom w up */
+  /*@}*/
+} Hierarchy;
+
+/** @brief Inicjalizuje pustą, wyłączoną hierarchię.
+ * @param[out] hierarchy      - wskaźnik na hierarchię
+ */
+void hierarchyInit(Hierarchy *hierarchy);
+
+/** @brief Zwalnia pamięć hierarchii, zachowując informację, czy jest włączona.
+ * @param[in, out] hierarchy      - wskaźnik na hierarchię
+ */
+void hierarchyFree(Hierarchy *hierarchy);
+
+/** @brief Oznacza hierarchię jako nieaktualną po zmianie sieci dróg.
+ * Koszt wyszukiwań wykonanych bez hierarchii liczony jest od nowa.
+ * @param[in, out] hierarchy      - wskaźnik na hierarchię
+ */
+void hierarchyInvalidate(Hierarchy *hierarchy);
+
+/** @brief Buduje hierarchię od nowa na podstawie sieci dróg.
+ * Jeśli skrótów okaże się zbyt wiele, hierarchia nie jest używana aż do
+ * następnej zmiany sieci. Zużyty czas procesora jest zapisywany w buildCost.
+ * @param[in, out] hierarchy      - wskaźnik na hierarchię
+ * @param[in] graph      - wskaźnik na aktualną reprezentację sieci dróg
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci
+ * (hierarchia pozostaje wtedy nieaktualna).
+ */
+bool hierarchyBuild(Hierarchy *hierarchy, Graph *graph);
+
+/** @brief Przepisuje lata krawędzi z odcinków dróg, jeśli były remontowane.
+ * @param[in, out] hierarchy      - wskaźnik na hierarchię
+ */
+void hierarchyUpdateYears(Hierarchy *hierarchy);
+
+/** @brief Dopisuje na koniec listy odcinki dróg zastępowane przez krawędź.
+ * @param[in] hierarchy      - wskaźnik na hierarchię
+ * @param[in] arc      - numer krawędzi
+ * @param[in] fromId      - koniec krawędzi, od którego mają być skierowane odcinki
+ * @param[in, out] pools      - wskaźnik na pule pamięci
+ * @param[in, out] tail      - wskaźnik na pole next ostatniego elementu listy (lub na jej początek)
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci
+ * (dopisane dotąd elementy pozostają na liście).
+ */
+bool hierarchyUnpack(Hierarchy *hierarchy, uint32_t arc, uint32_t fromId, Pools *pools, ListNode ***tail);
+
+#endif /* __HIERARCHY_H__ */
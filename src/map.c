@@ -6,110 +6,259 @@
 #include <inttypes.h>
 #include "types.h"
 #include "tools.h"
-
-static const uint64_t INFINITY = 9223372036854775807;
+#include "hash.h"
+#include "heap.h"
+#include "graph.h"
+#include "hierarchy.h"
+#include "route.h"
+#include "workers.h"
 
 /**
   * Struktura reprezentująca mapę dróg
   */
 typedef struct Map {
   /*@{*/
-  TreapNode *cities; /**< Treap zawierający miasta */
-  ListNode **routes; /**< Tablica dróg krajowych (reprezentowanych przez listy struktur Neigh) */
+  CityTable cities; /**< Tablica miast (identyfikatory i wyszukiwanie po nazwie) */
+  EdgeTable roads; /**< Indeks odcinków dróg po parach miast */
+  Graph graph; /**< Listy sąsiedztwa w postaci CSR, na których działa wyszukiwanie */
+  Landmarks landmarks; /**< Punkty orientacyjne wyszukiwania A* (domyślnie wyłączone) */
+  Hierarchy hierarchy; /**< Hierarchia kontrakcyjna (domyślnie wyłączona) */
+  Pools pools; /**< Pule pamięci, z których pochodzą obiekty mapy */
+  SearchState search; /**< Stan roboczy wyszukiwania ścieżek, wielokrotnego użytku */
+  SearchState backward; /**< Stan roboczy wyszukiwania wstecz (od miasta docelowego) */
+  uint32_t workersCount; /**< liczba wątków naprawiających drogi krajowe w removeRoad */
+  SearchState *workers; /**< stany wyszukiwania wątków o numerach od 1, po dwa na wątek (wątek 0 używa search i backward) */
+  RouteTable routes; /**< Drogi krajowe według numerów */
   /*}@*/
 } Map;
 
 bool routeExists(Map *map, uint32_t routeId){
-  if(map->routes[routeId] == NULL) return false;
+  return routeTableFind(&(map->routes), routeId) != NULL;
+}
+
+static void unmarkRoute(Neigh **roads, uint32_t count, uint32_t routeId){
+  for(uint32_t i = 0; i < count; i++) neighRemoveRoute(roads[i], routeId);
+}
+
+// Oznacza odcinki jako należące do drogi krajowej i zapewnia w niej na nie
+// miejsce, więc ich późniejsze wstawienie do drogi nie alokuje pamięci.
+static bool markRoute(Map *map, Neigh **roads, uint32_t count, Route *route){
+  for(uint32_t i = 0; i < count; i++){
+    if(!neighAddRoute(&(map->pools), roads[i], route->id)){
+      unmarkRoute(roads, i, route->id);
+      return false;
+    }
+  }
+  if(!routeReserve(route, count)){
+    unmarkRoute(roads, count, route->id);
+    return false;
+  }
   return true;
 }
 
-void setRoute(Map *map, uint32_t routeId, ListNode *list){
-  map->routes[routeId] = list;
+// Przepisuje odcinki z listy do nowej tablicy; lista jest zwalniana.
+static bool arrayFromList(Map *map, ListNode *list, Neigh ***roads, uint32_t *count){
+  *count = 0;
+  for(ListNode *ptr = list; ptr != NULL; ptr = ptr->next) (*count)++;
 
-  ListNode *ptr = list;
-  while(ptr != NULL){
-    Neigh *val = (Neigh*)(ptr->valPtr);
-    val->localRoutes[routeId] = true;
-    val->reversed->localRoutes[routeId] = true;
-    ptr = ptr->next;
+  *roads = (Neigh**)malloc(*count * sizeof(Neigh*));
+  if(*roads != NULL){
+    uint32_t i = 0;
+    for(ListNode *ptr = list; ptr != NULL; ptr = ptr->next) (*roads)[i++] = (Neigh*)(ptr->valPtr);
   }
+  freeList(&(map->pools), list);
+  return *roads != NULL;
+}
+
+bool setRoute(Map *map, uint32_t routeId, Neigh **roads, uint32_t count){
+  if(!routeTableReserve(&(map->routes), 1)) return false;
+  Route *route = (Route*)malloc(sizeof(Route));
+  if(route == NULL) return false;
+  routeInit(route, routeId);
+
+  if(!markRoute(map, roads, count, route)){
+    routeFree(route);
+    free(route);
+    return false;
+  }
+  routeAppend(route, roads, count);
+  routeTableAdd(&(map->routes), route);
+  return true;
 }
 
 Map *newMap(){
   Map *newMapPtr = (Map*)malloc(sizeof(Map));
   if(newMapPtr == NULL) return NULL;
 
-  newMapPtr->routes = (ListNode**)malloc(sizeof(ListNode*) * 1000);
-  if(newMapPtr->routes == NULL){
+  poolsInit(&(newMapPtr->pools));
+  searchStateInit(&(newMapPtr->search), QUEUE_HEAP);
+  searchStateInit(&(newMapPtr->backward), QUEUE_HEAP);
+  graphInit(&(newMapPtr->graph));
+  newMapPtr->workersCount = 1;
+  newMapPtr->workers = NULL;
+  landmarksInit(&(newMapPtr->landmarks), 0);
+  hierarchyInit(&(newMapPtr->hierarchy));
+  routeTableInit(&(newMapPtr->routes));
+
+  if(!cityTableInit(&(newMapPtr->cities))){
+    poolsDestroy(&(newMapPtr->pools));
     free(newMapPtr);
     return NULL;
   }
-  for(int32_t i = 0; i < 1000; i++) newMapPtr->routes[i] = NULL;
 
-  newMapPtr->cities = NULL;
+  if(!edgeTableInit(&(newMapPtr->roads))){
+    cityTableFree(&(newMapPtr->cities));
+    poolsDestroy(&(newMapPtr->pools));
+    free(newMapPtr);
+    return NULL;
+  }
 
   return newMapPtr;
 }
 
-void deleteMap(Map *mapPtr){
-  deleteCityTreap(mapPtr->cities);
+void setQueueKind(Map *map, QueueKind kind){
+  pqSetKind(&(map->search.queue), kind);
+  pqSetKind(&(map->backward.queue), kind);
+  for(uint32_t w = 2; w < 2 * map->workersCount; w++){
+    pqSetKind(&(map->workers[w - 2].queue), kind);
+  }
+}
+
+static void freeWorkers(Map *map){
+  for(uint32_t w = 2; w < 2 * map->workersCount; w++){
+    searchStateFree(&(map->workers[w - 2]));
+  }
+  free(map->workers);
+  map->workers = NULL;
+  map->workersCount = 1;
+}
 
-  for(int32_t i=1; i<1000; i++){
-     ListNode *listPtr = mapPtr->routes[i];
+bool setWorkers(Map *map, uint32_t count){
+  freeWorkers(map);
+  if(count <= 1) return true;
 
-     while(listPtr != NULL){
-       ListNode *l = listPtr->next;
-       free(listPtr);
-       listPtr = l;
-     }
+  map->workers = (SearchState*)malloc(2 * (count - 1) * sizeof(SearchState));
+  if(map->workers == NULL) return false;
+  for(uint32_t w = 2; w < 2 * count; w++){
+    searchStateInit(&(map->workers[w - 2]), map->search.queue.kind);
   }
+  map->workersCount = count;
+  return true;
+}
 
-  free(mapPtr->routes);
-  mapPtr->routes = NULL;
+void setLandmarks(Map *map, uint32_t count){
+  landmarksFree(&(map->landmarks));
+  landmarksInit(&(map->landmarks), count);
+}
 
-  free(mapPtr);
+static Landmarks *prepareLandmarks(Map *map){
+  Landmarks *landmarks = &(map->landmarks);
+  if(landmarks->count == 0) return NULL;
+
+  if(landmarks->stale || landmarks->rows != map->graph.rows){
+    // Przeliczenie kosztuje tyle, co count pełnych wyszukiwań, więc po zmianie
+    // sieci wykonujemy je dopiero, gdy tyle wyszukiwań obyło się bez tablic.
+    if(landmarks->cities != NULL && landmarks->staleSearches < landmarks->count){
+      landmarks->staleSearches++;
+      return NULL;
+    }
+    if(!landmarksBuild(landmarks, &(map->graph), &(map->search))) return NULL;
+  }
+  return landmarks;
 }
 
-bool searchCity(Map *map, char *city, City **target){
-  City *temp = createCity(city);
-  if(temp == NULL){
-    return false;
+void setHierarchy(Map *map, bool enabled){
+  hierarchyFree(&(map->hierarchy));
+  hierarchyInit(&(map->hierarchy));
+  map->hierarchy.enabled = enabled;
+}
+
+static Hierarchy *prepareHierarchy(Map *map){
+  Hierarchy *hierarchy = &(map->hierarchy);
+  if(!hierarchy->enabled) return NULL;
+
+  if(hierarchy->stale){
+    // Przebudowa opłaca się dopiero, gdy wyszukiwania bez hierarchii od
+    // ostatniej zmiany sieci kosztowały więcej niż poprzednia budowa. Przy
+    // częstych zmianach hierarchia nie jest więc przebudowywana wcale.
+    if(!hierarchy->built || hierarchy->staleCost >= hierarchy->buildCost){
+      hierarchyBuild(hierarchy, &(map->graph));
+    }
+    if(hierarchy->stale){
+      hierarchy->searchStart = clock();
+      return NULL;
+    }
   }
-  City *cityPtr = (City*)search(map->cities, temp, 1);
-  deleteCity(temp);
-  *target = cityPtr;
-  return true;
+  if(!hierarchy->ready) return NULL;
+
+  hierarchyUpdateYears(hierarchy);
+  return hierarchy;
 }
 
-bool searchNeigh(TreapNode *neighs, City *cityPtr, Neigh **target){
-  Neigh *temp = createNeigh(cityPtr, 0, 0);
-  if(temp == NULL) return false;
-  Neigh *result = (Neigh*)search(neighs, temp, 2);
-  free(temp);
-  *target = result;
-  return true;
+// Dolicza czas wyszukiwania, które obeszło się bez nieaktualnej hierarchii.
+static void chargeStaleSearch(Map *map){
+  Hierarchy *hierarchy = &(map->hierarchy);
+  if(hierarchy->enabled && hierarchy->stale) hierarchy->staleCost += clock() - hierarchy->searchStart;
+}
+
+void deleteMap(Map *mapPtr){
+  // Obiekty mapy pochodzą z pul i są zwalniane razem z nimi; osobno
+  // zwalniamy jedynie tablice wpisów zbiorów dróg krajowych odcinków.
+  EdgeTable *roads = &(mapPtr->roads);
+  for(uint32_t i = 0; i < roads->slotsCount; i++){
+    Neigh *neighPtr = roads->slots[i].neigh;
+    if(neighPtr != NULL && neighPtr->localRoutes != NULL){
+      free(neighPtr->localRoutes->routeIds);
+    }
+  }
+
+  edgeTableFree(&(mapPtr->roads));
+  cityTableFree(&(mapPtr->cities));
+  poolsDestroy(&(mapPtr->pools));
+  searchStateFree(&(mapPtr->search));
+  searchStateFree(&(mapPtr->backward));
+  freeWorkers(mapPtr);
+  graphFree(&(mapPtr->graph));
+  landmarksFree(&(mapPtr->landmarks));
+  hierarchyFree(&(mapPtr->hierarchy));
+
+  routeTableFree(&(mapPtr->routes));
+
+  free(mapPtr);
+}
+
+City *searchCity(Map *map, const char *city){
+  return cityTableFind(&(map->cities), city);
+}
+
+Neigh *searchNeigh(Map *map, City *cityPtr1, City *cityPtr2){
+  return edgeTableFind(&(map->roads), cityPtr1, cityPtr2);
 }
 
 bool searchRoad(Map *map, const char *city1, const char *city2, Neigh **target){
   if(*city1 == 0 || *city2 == 0) return false;
   if(map == NULL || strcmp(city1, city2) == 0) return false;
 
-  City *cityPtr1 = NULL;
-  City *cityPtr2 = NULL;
-
-  if(!searchCity(map, (char *)city1, &cityPtr1)) return false;
-  if(!searchCity(map, (char *)city2, &cityPtr2)) return false;
+  City *cityPtr1 = searchCity(map, city1);
+  City *cityPtr2 = searchCity(map, city2);
 
   if(cityPtr1 == NULL || cityPtr2 == NULL) return false;
 
-  Neigh *neighPtr = NULL;
-  if(!searchNeigh(cityPtr1->neighbours, cityPtr2, &neighPtr)) return false;
-
-  *target = neighPtr;
+  *target = searchNeigh(map, cityPtr1, cityPtr2);
   return true;
 }
 
+static void forgetCities(Map *map, City *cityPtr1, bool wasAdded1, City *cityPtr2, bool wasAdded2){
+  if(wasAdded2){
+    cityTableRemoveLast(&(map->cities));
+    deleteCity(&(map->pools), cityPtr2);
+  }
+  if(wasAdded1){
+    cityTableRemoveLast(&(map->cities));
+    deleteCity(&(map->pools), cityPtr1);
+  }
+}
+
 bool addRoad(Map *map, const char *city1, const char *city2, unsigned length, int builtYear){
   if(*city1 == 0 || *city2 == 0) return false;
 
@@ -117,112 +266,67 @@ bool addRoad(Map *map, const char *city1, const char *city2, unsigned length, in
     return false;
   }
 
-  City *cityPtr1 = NULL;
-  City *cityPtr2 = NULL;
-
-  if(!searchCity(map, (char *)city1, &cityPtr1)) return false;
-  if(!searchCity(map, (char *)city2, &cityPtr2)) return false;
+  City *cityPtr1 = searchCity(map, city1);
+  City *cityPtr2 = searchCity(map, city2);
 
   bool wasAdded1 = false;
   bool wasAdded2 = false;
 
   if(cityPtr1 != NULL && cityPtr2 != NULL){
-    Neigh *neighPtr = NULL;
-    if(!searchNeigh(cityPtr1->neighbours, cityPtr2, &neighPtr)) return false;
-    if(neighPtr != NULL) return false;
+    if(searchNeigh(map, cityPtr1, cityPtr2) != NULL) return false;
   }
 
   if(cityPtr1 == NULL){
-    cityPtr1 = createCity((char *)city1);
+    cityPtr1 = createCity(&(map->pools), city1);
     if(cityPtr1 == NULL) return false;
-    if(!insert(&(map->cities), cityPtr1, 1)){
-      free(cityPtr1);
+    if(!cityTableAdd(&(map->cities), cityPtr1)){
+      deleteCity(&(map->pools), cityPtr1);
       return false;
     }
     wasAdded1 = true;
   }
 
   if(cityPtr2 == NULL){
-    cityPtr2 = createCity((char *)city2);
+    cityPtr2 = createCity(&(map->pools), city2);
     if(cityPtr2 == NULL){
-      if(wasAdded1){
-        removeNode(&(map->cities), cityPtr1, 1);
-        free(cityPtr1);
-      }
+      forgetCities(map, cityPtr1, wasAdded1, NULL, false);
       return false;
     }
-    if(!insert(&(map->cities), cityPtr2, 1)){
-      if(wasAdded1){
-        removeNode(&(map->cities), cityPtr1, 1);
-        free(cityPtr1);
-      }
-      free(cityPtr2);
+    if(!cityTableAdd(&(map->cities), cityPtr2)){
+      deleteCity(&(map->pools), cityPtr2);
+      forgetCities(map, cityPtr1, wasAdded1, NULL, false);
       return false;
     }
     wasAdded2 = true;
   }
 
-  Neigh *neighPtr1 = createNeigh(cityPtr2, length, builtYear);
+  Neigh *neighPtr1 = createNeigh(&(map->pools), cityPtr2, length, builtYear);
   if(neighPtr1 == NULL){
-    if(wasAdded1){
-      removeNode(&(map->cities), cityPtr1, 1);
-      free(cityPtr1);
-    }
-    if(wasAdded2){
-      removeNode(&(map->cities), cityPtr2, 1);
-      free(cityPtr2);
-    }
+    forgetCities(map, cityPtr1, wasAdded1, cityPtr2, wasAdded2);
     return false;
   }
 
-  Neigh *neighPtr2 = createNeigh(cityPtr1, length, builtYear);
+  Neigh *neighPtr2 = createNeigh(&(map->pools), cityPtr1, length, builtYear);
   if(neighPtr2 == NULL){
-    if(wasAdded1){
-      removeNode(&(map->cities), cityPtr1, 1);
-      free(cityPtr1);
-    }
-    if(wasAdded2){
-      removeNode(&(map->cities), cityPtr2, 1);
-      free(cityPtr2);
-    }
-    free(neighPtr1);
+    deleteNeigh(&(map->pools), neighPtr1);
+    forgetCities(map, cityPtr1, wasAdded1, cityPtr2, wasAdded2);
     return false;
   }
 
-  neighRoutesInit(neighPtr1);
-  neighRoutesInit(neighPtr2);
   neighPtr1->reversed = neighPtr2;
   neighPtr2->reversed = neighPtr1;
 
-  if(!insert(&(cityPtr1->neighbours), neighPtr1, 2)){
-    if(wasAdded1){
-      removeNode(&(map->cities), cityPtr1, 1);
-      free(cityPtr1);
-    }
-    if(wasAdded2){
-      removeNode(&(map->cities), cityPtr2, 1);
-      free(cityPtr2);
-    }
-    free(neighPtr1);
-    free(neighPtr2);
-    return false;
-  }
-
-  if(!insert(&(cityPtr2->neighbours), neighPtr2, 2)){
-    if(wasAdded1){
-      removeNode(&(map->cities), cityPtr1, 1);
-      free(cityPtr1);
-    }
-    if(wasAdded2){
-      removeNode(&(map->cities), cityPtr2, 1);
-      free(cityPtr2);
-    }
-    free(neighPtr1);
-    free(neighPtr2);
-    removeNode(&(cityPtr1->neighbours), neighPtr1, 2);
+  if(!edgeTableAdd(&(map->roads), neighPtr1)){
+    deleteNeigh(&(map->pools), neighPtr1);
+    deleteNeigh(&(map->pools), neighPtr2);
+    forgetCities(map, cityPtr1, wasAdded1, cityPtr2, wasAdded2);
     return false;
   }
 
+  graphAddEdge(&(map->graph), neighPtr1);
+  graphAddEdge(&(map->graph), neighPtr2);
+  map->landmarks.stale = true;
+  hierarchyInvalidate(&(map->hierarchy));
   return true;
 }
 
@@ -232,21 +336,16 @@ bool repairRoad(Map *map, const char *city1, const char *city2, int repairYear){
     return false;
   }
 
-  City *cityPtr1 = NULL;
-  City *cityPtr2 = NULL;
-
-  if(!searchCity(map, (char *)city1, &cityPtr1)) return false;
-  if(!searchCity(map, (char *)city2, &cityPtr2)) return false;
+  City *cityPtr1 = searchCity(map, city1);
+  City *cityPtr2 = searchCity(map, city2);
 
   if(cityPtr1 == NULL || cityPtr2 == NULL){
     return false;
   }
 
-  Neigh *neighbour1 = NULL;
-  Neigh *neighbour2 = NULL;
-  if(!searchNeigh(cityPtr1->neighbours, cityPtr2, &neighbour1)) return false;
+  Neigh *neighbour1 = searchNeigh(map, cityPtr1, cityPtr2);
   if(neighbour1 == NULL) return false;
-  neighbour2 = neighbour1->reversed;
+  Neigh *neighbour2 = neighbour1->reversed;
 
   if(repairYear < neighbour1->date){
     return false;
@@ -254,302 +353,420 @@ bool repairRoad(Map *map, const char *city1, const char *city2, int repairYear){
 
   neighbour1->date = repairYear;
   neighbour2->date = repairYear;
+  graphUpdateEdge(&(map->graph), neighbour1);
+  graphUpdateEdge(&(map->graph), neighbour2);
+  map->hierarchy.yearsStale = true;
 
   return true;
 }
 
+// Wyznacza najlepszą ścieżkę między miastami. Hierarchia jest używana, gdy jej
+// wynik jest rozstrzygający.
+static bool searchPath(Map *map, City *cityPtr1, City *cityPtr2, Landmarks *landmarks, Hierarchy *hierarchy, ListNode **target){
+  if(hierarchy != NULL){
+    bool decided;
+    uint64_t dist;
+    int32_t youngestOldest;
+    if(!findShortestPathHierarchy(cityPtr1, cityPtr2, NULL, hierarchy, &(map->pools), &(map->search), &(map->backward), &decided, &dist, &youngestOldest, target)){
+      return false;
+    }
+    if(decided) return true;
+  }
+
+  if(landmarks != NULL){
+    return findShortestPath(cityPtr1, cityPtr2, NULL, NULL, NULL, &(map->graph), landmarks, &(map->pools), &(map->search), target);
+  }
+  return findShortestPathBidirectional(cityPtr1, cityPtr2, &(map->graph), &(map->pools), &(map->search), &(map->backward), target);
+}
+
+// Wyznacza za pomocą hierarchii fragment wydłużający drogę krajową: najlepsze
+// ścieżki od nowego miasta do pierwszego miasta drogi i od ostatniego miasta
+// do nowego. Jeśli któreś z wyszukiwań nie jest rozstrzygające, decided
+// jest równe false.
+static bool extendByHierarchy(Map *map, Hierarchy *hierarchy, const CityIndex *route, City *begCity, City *endCity, City *cityPtr, bool *decided, ListNode **target, bool *atBeginning){
+  ListNode *begPath = NULL;
+  uint64_t begDist;
+  int32_t begYoungestOldest;
+  if(!findShortestPathHierarchy(cityPtr, begCity, route, hierarchy, &(map->pools), &(map->search), &(map->backward), decided, &begDist, &begYoungestOldest, &begPath)){
+    return false;
+  }
+  if(!*decided) return true;
+
+  ListNode *endPath = NULL;
+  uint64_t endDist;
+  int32_t endYoungestOldest;
+  if(!findShortestPathHierarchy(endCity, cityPtr, route, hierarchy, &(map->pools), &(map->search), &(map->backward), decided, &endDist, &endYoungestOldest, &endPath)){
+    freeList(&(map->pools), begPath);
+    return false;
+  }
+  if(!*decided){
+    freeList(&(map->pools), begPath);
+    return true;
+  }
+
+  bool useBeg = begDist < endDist || (begDist == endDist && begYoungestOldest > endYoungestOldest);
+  bool useEnd = endDist < begDist || (begDist == endDist && endYoungestOldest > begYoungestOldest);
+  *target = NULL;
+  *atBeginning = useBeg;
+  if(useBeg){
+    *target = begPath;
+    begPath = NULL;
+  }
+  if(useEnd){
+    *target = endPath;
+    endPath = NULL;
+  }
+  freeList(&(map->pools), begPath);
+  freeList(&(map->pools), endPath);
+  return true;
+}
+
 bool newRoute(Map *map, unsigned routeId, const char *city1, const char *city2){
   if(*city1 == 0 || *city2 == 0) return false;
-  if(map == NULL || routeId == 0 || routeId > 999 || strcmp(city1, city2) == 0){
+  if(map == NULL || routeId == 0 || strcmp(city1, city2) == 0){
     return false;
   }
-  if(map->routes[routeId] != NULL){
+  if(routeExists(map, routeId)){
     return false;
   }
 
-  City *cityPtr1 = NULL;
-  City *cityPtr2 = NULL;
-
-  if(!searchCity(map, (char *)city1, &cityPtr1)) return false;
-  if(!searchCity(map, (char *)city2, &cityPtr2)) return false;
+  City *cityPtr1 = searchCity(map, city1);
+  City *cityPtr2 = searchCity(map, city2);
 
   if(cityPtr1 == NULL || cityPtr2 == NULL){
     return false;
   }
 
   ListNode *shortestPath = NULL;
-  if(!findShortestPath(cityPtr1, cityPtr2, NULL, map->cities, NULL, &shortestPath)){
+  if(!graphSync(&(map->graph), &(map->cities), &(map->roads))) return false;
+  Landmarks *landmarks = prepareLandmarks(map);
+  Hierarchy *hierarchy = prepareHierarchy(map);
+  if(!searchPath(map, cityPtr1, cityPtr2, landmarks, hierarchy, &shortestPath)){
     return false;
   }
+  if(hierarchy == NULL) chargeStaleSearch(map);
 
   if(shortestPath == NULL) return false;
 
-  map->routes[routeId] = shortestPath;
-
-  ListNode *pathPtr = shortestPath;
-  while(pathPtr != NULL){
-    Neigh *neigh = (Neigh*)(pathPtr->valPtr);
-    neigh->localRoutes[routeId] = true;
-    neigh->reversed->localRoutes[routeId] = true;
-    pathPtr = pathPtr->next;
-  }
-
-  return true;
+  Neigh **roads;
+  uint32_t count;
+  if(!arrayFromList(map, shortestPath, &roads, &count)) return false;
+  bool ok = setRoute(map, routeId, roads, count);
+  free(roads);
+  return ok;
 }
 
-bool extendRoute(Map *map, unsigned routeId, const char *city){
-  if(*city == 0) return false;
-  if(map == NULL || routeId == 0 || routeId > 999){
-    return false;
-  }
-  if(map->routes[routeId] == NULL) return false;
-
-  City *cityPtr = NULL;
-  if(!searchCity(map, (char*)city, &cityPtr)) return false;
-  if(cityPtr == NULL) return false;
+/**
+ * Stan tworzenia wielu dróg krajowych o wspólnym mieście początkowym.
+ */
+typedef struct Batch {
+  /*@{*/
+  uint32_t count; /**< liczba tworzonych dróg krajowych */
+  City **targets; /**< miasta końcowe kolejnych dróg */
+  Neigh ***paths; /**< odcinki kolejnych dróg */
+  uint32_t *lengths; /**< liczby odcinków kolejnych dróg */
+  Route **routes; /**< tworzone drogi krajowe */
+  /*@}*/
+} Batch;
+
+static void freeBatch(Batch *batch){
+  for(uint32_t k = 0; batch->paths != NULL && k < batch->count; k++) free(batch->paths[k]);
+  free(batch->targets);
+  free(batch->paths);
+  free(batch->lengths);
+  free(batch->routes);
+}
 
-  ListNode *listPtr = map->routes[routeId];
+static int compareRouteIds(const void *ptrA, const void *ptrB){
+  unsigned a = *(const unsigned*)ptrA;
+  unsigned b = *(const unsigned*)ptrB;
+  return (a > b) - (a < b);
+}
 
-  if(((Neigh*)(listPtr->valPtr))->reversed->dest == cityPtr) return false;
+// Sprawdza, czy numery dróg są niezerowe, różne i wolne.
+static bool checkRouteIds(Map *map, uint32_t count, const unsigned *routeIds, bool *valid){
+  unsigned *sorted = (unsigned*)malloc(count * sizeof(unsigned));
+  if(sorted == NULL) return false;
+  memcpy(sorted, routeIds, count * sizeof(unsigned));
+  qsort(sorted, count, sizeof(unsigned), compareRouteIds);
 
-  bool found = false;
-  while(true){
-    if(((Neigh*)(listPtr->valPtr))->dest == cityPtr) found = true;
-    if(listPtr->next == NULL) break;
-    listPtr = listPtr->next;
+  *valid = true;
+  for(uint32_t k = 0; *valid && k < count; k++){
+    if(sorted[k] == 0 || routeExists(map, sorted[k]) || (k > 0 && sorted[k] == sorted[k - 1])) *valid = false;
   }
-  if(found) return false;
-
-  City *begCity = ((Neigh*)(map->routes[routeId]->valPtr))->reversed->dest;
-  City *endCity = ((Neigh*)(listPtr->valPtr))->dest;
+  free(sorted);
+  return true;
+}
 
-  ListNode *begPath = NULL;
-  if(!findShortestPath(begCity, cityPtr, map->routes[routeId], map->cities, NULL, &begPath)){
+bool newRoutes(Map *map, const char *city, uint32_t count, const unsigned *routeIds, const char **cities){
+  if(map == NULL || count == 0 || *city == 0) return false;
+
+  City *source = searchCity(map, city);
+  if(source == NULL) return false;
+
+  Batch batch;
+  batch.count = count;
+  batch.targets = (City**)malloc(count * sizeof(City*));
+  batch.paths = (Neigh***)calloc(count, sizeof(Neigh**));
+  batch.lengths = (uint32_t*)calloc(count, sizeof(uint32_t));
+  batch.routes = (Route**)calloc(count, sizeof(Route*));
+  bool valid = false;
+  if(batch.targets == NULL || batch.paths == NULL || batch.lengths == NULL || batch.routes == NULL ||
+     !checkRouteIds(map, count, routeIds, &valid) || !valid){
+    freeBatch(&batch);
     return false;
   }
 
-  ListNode *oldList = begPath;
-  if(!reverseNeighList(begPath, &begPath)){
-      freeList(begPath);
+  for(uint32_t k = 0; k < count; k++){
+    if(*cities[k] == 0 || strcmp(cities[k], city) == 0) valid = false;
+    else batch.targets[k] = searchCity(map, cities[k]);
+    if(!valid || batch.targets[k] == NULL){
+      freeBatch(&batch);
       return false;
+    }
   }
-  freeList(oldList);
-
-  uint64_t begDist = cityPtr->dijkDist;
-  int32_t begYoungestOldest = cityPtr->dijkYoungestOldest;
 
-  ListNode *endPath = NULL;
-  if(!findShortestPath(endCity, cityPtr, map->routes[routeId], map->cities, NULL, &endPath)){
-    freeList(begPath);
+  // Jedno wyszukiwanie od wspólnego miasta wyznacza drzewo najlepszych
+  // ścieżek, z którego odczytywane są wszystkie drogi.
+  if(!graphSync(&(map->graph), &(map->cities), &(map->roads)) ||
+     !findShortestPathsFrom(source, batch.targets, count, &(map->graph), &(map->search), batch.paths, batch.lengths)){
+    freeBatch(&batch);
     return false;
   }
-  uint64_t endDist = cityPtr->dijkDist;
-  int32_t endYoungestOldest = cityPtr->dijkYoungestOldest;
-
-  if(begDist < endDist){
-    if(begPath != NULL){
-      ListNode *begPathPtr = begPath;
-
-      while(true){
-        Neigh *neigh = (Neigh*)(begPathPtr->valPtr);
-        neigh->localRoutes[routeId] = true;
-        neigh->reversed->localRoutes[routeId] = true;
-        if(begPathPtr->next == NULL) break;
-        begPathPtr = begPathPtr->next;
-      }
-      begPathPtr->next = map->routes[routeId];
-      map->routes[routeId] = begPath;
-
-      freeList(endPath);
-      return true;
+  for(uint32_t k = 0; k < count; k++){
+    if(batch.paths[k] == NULL){
+      freeBatch(&batch);
+      return false;
     }
   }
 
-  else if(endDist < begDist){
-    if(endPath != NULL){
-      listPtr->next = endPath;
+  // Drogi są dodawane wszystkie albo żadna: pamięć jest rezerwowana przed
+  // zmianą mapy.
+  bool ok = routeTableReserve(&(map->routes), count);
+  uint32_t marked = 0;
+  while(ok && marked < count){
+    Route *route = (Route*)malloc(sizeof(Route));
+    batch.routes[marked] = route;
+    if(route == NULL){
+      ok = false;
+      break;
+    }
+    routeInit(route, routeIds[marked]);
+    if(!markRoute(map, batch.paths[marked], batch.lengths[marked], route)) ok = false;
+    else marked++;
+  }
+  if(!ok){
+    for(uint32_t k = 0; k < marked; k++){
+      unmarkRoute(batch.paths[k], batch.lengths[k], routeIds[k]);
+    }
+    for(uint32_t k = 0; k < count && batch.routes[k] != NULL; k++){
+      routeFree(batch.routes[k]);
+      free(batch.routes[k]);
+    }
+    freeBatch(&batch);
+    return false;
+  }
 
-      ListNode *endPathPtr = endPath;
-      while(endPathPtr != NULL){
-        Neigh *neigh = (Neigh*)(endPathPtr->valPtr);
-        neigh->localRoutes[routeId] = true;
-        neigh->reversed->localRoutes[routeId] = true;
-        endPathPtr = endPathPtr->next;
-      }
+  for(uint32_t k = 0; k < count; k++){
+    routeAppend(batch.routes[k], batch.paths[k], batch.lengths[k]);
+    routeTableAdd(&(map->routes), batch.routes[k]);
+  }
+  freeBatch(&batch);
+  return true;
+}
 
-      freeList(begPath);
-      return true;
-    }
+bool extendRoute(Map *map, unsigned routeId, const char *city){
+  if(*city == 0) return false;
+  if(map == NULL || routeId == 0){
+    return false;
   }
+  Route *route = routeTableFind(&(map->routes), routeId);
+  if(route == NULL) return false;
+
+  City *cityPtr = searchCity(map, city);
+  if(cityPtr == NULL) return false;
 
-  else if(begDist != INFINITY) {
-    if(begYoungestOldest > endYoungestOldest){
-      if(begPath != NULL){
-        ListNode *begPathPtr = begPath;
+  if(cityIndexHas(&(route->positions), cityPtr->id)) return false;
 
-        while(true){
-          Neigh *neigh = (Neigh*)(begPathPtr->valPtr);
-          neigh->localRoutes[routeId] = true;
-          neigh->reversed->localRoutes[routeId] = true;
-          if(begPathPtr->next == NULL) break;
-          begPathPtr = begPathPtr->next;
-        }
-        begPathPtr->next = map->routes[routeId];
-        map->routes[routeId] = begPath;
+  City *begCity = routeFirstCity(route);
+  City *endCity = routeLastCity(route);
 
-        freeList(endPath);
-        return true;
-      }
-    }
+  if(!graphSync(&(map->graph), &(map->cities), &(map->roads))) return false;
+  Landmarks *landmarks = prepareLandmarks(map);
+  Hierarchy *hierarchy = prepareHierarchy(map);
 
-    else if(endYoungestOldest > begYoungestOldest){
-      if(endPath != NULL){
-        listPtr->next = endPath;
+  ListNode *path = NULL;
+  bool atBeginning = false;
+  bool decided = false;
+  if(hierarchy != NULL && !extendByHierarchy(map, hierarchy, &(route->positions), begCity, endCity, cityPtr, &decided, &path, &atBeginning)){
+    return false;
+  }
+  if(!decided && !findExtension(begCity, endCity, cityPtr, &(route->positions), &(map->graph), landmarks, &(map->pools), &(map->search), &path, &atBeginning)){
+    return false;
+  }
+  if(hierarchy == NULL) chargeStaleSearch(map);
 
-        ListNode *endPathPtr = endPath;
-        while(endPathPtr != NULL){
-          Neigh *neigh = (Neigh*)(endPathPtr->valPtr);
-          neigh->localRoutes[routeId] = true;
-          neigh->reversed->localRoutes[routeId] = true;
-          endPathPtr = endPathPtr->next;
-        }
+  if(path == NULL) return false;
 
-        freeList(begPath);
-        return true;
-      }
-    }
+  Neigh **roads;
+  uint32_t count;
+  if(!arrayFromList(map, path, &roads, &count)) return false;
+  if(!markRoute(map, roads, count, route)){
+    free(roads);
+    return false;
   }
 
-  freeList(begPath);
-  freeList(endPath);
-  return false;
+  if(atBeginning) routePrepend(route, roads, count);
+  else routeAppend(route, roads, count);
+  free(roads);
+  return true;
 }
 
-bool removeRoad(Map *map, const char *city1, const char *city2){
+bool routeDistance(Map *map, const char *city1, const char *city2, uint64_t *length, int32_t *year){
   if(*city1 == 0 || *city2 == 0) return false;
   if(map == NULL || strcmp(city1, city2) == 0) return false;
 
-  City *cityPtr1 = NULL;
-  City *cityPtr2 = NULL;
-  if(!searchCity(map, (char*)city1, &cityPtr1)) return false;
-  if(!searchCity(map, (char*)city2, &cityPtr2)) return false;
+  City *cityPtr1 = searchCity(map, city1);
+  City *cityPtr2 = searchCity(map, city2);
 
   if(cityPtr1 == NULL || cityPtr2 == NULL){
     return false;
   }
 
-  Neigh *neighbour2 = NULL;
-  if(!searchNeigh(cityPtr1->neighbours, cityPtr2, &neighbour2)) return false;
-  if(neighbour2 == NULL) return false;
-
-  ListNode ***leftPointers = (ListNode***)malloc(1000 * sizeof(ListNode**));
-  if(leftPointers == NULL) return false;
-
-  ListNode **rightPointers = (ListNode**)malloc(1000 * sizeof(ListNode*));
-  if(rightPointers == NULL){
-    free(leftPointers);
-    return false;
+  if(!graphSync(&(map->graph), &(map->cities), &(map->roads))) return false;
+  Hierarchy *hierarchy = prepareHierarchy(map);
+  if(hierarchy != NULL){
+    if(!distanceHierarchy(cityPtr1, cityPtr2, hierarchy, &(map->search), &(map->backward), length, year)) return false;
+  } else {
+    if(!findDistance(cityPtr1, cityPtr2, &(map->graph), prepareLandmarks(map), &(map->search))) return false;
+    chargeStaleSearch(map);
+    *length = searchDist(&(map->search), cityPtr2);
+    *year = searchYoungestOldest(&(map->search), cityPtr2);
   }
 
-  ListNode **paths = (ListNode* *)malloc(1000 * sizeof(ListNode*));
-  if(paths == NULL){
-    free(leftPointers);
-    free(rightPointers);
-    return false;
-  }
+  return *length != INT64_MAX;
+}
 
-  for(int i=0; i<1000; i++){
-    leftPointers[i] = NULL;
-    rightPointers[i] = NULL;
-    paths[i] = NULL;
-  }
+/**
+ * Dane wspólne wyszukiwań objazdów w removeRoad.
+ */
+typedef struct Repairs {
+  /*@{*/
+  Map *map; /**< mapa */
+  uint32_t count; /**< liczba dróg krajowych przechodzących przez usuwany odcinek */
+  Route **routes; /**< drogi krajowe przechodzące przez usuwany odcinek */
+  Landmarks *landmarks; /**< punkty orientacyjne lub NULL */
+  uint32_t *positions; /**< numery usuwanego odcinka w kolejnych drogach krajowych */
+  Neigh ***detours; /**< objazdy kolejnych dróg krajowych */
+  uint32_t *lengths; /**< liczby odcinków objazdów */
+  /*@}*/
+} Repairs;
+
+// Wyszukiwania objazdów jedynie czytają sieć dróg i drogi krajowe, a każdy
+// wątek ma własne stany wyszukiwania, więc mogą działać jednocześnie. Bez
+// punktów orientacyjnych objazd jest szukany od obu końców usuniętego odcinka,
+// więc przeszukiwane jest tylko jego otoczenie.
+static bool repairRoute(void *context, uint32_t worker, uint32_t k){
+  Repairs *repairs = (Repairs*)context;
+  Map *map = repairs->map;
+  Route *route = repairs->routes[k];
+  Neigh *orientedRoad = routeRoad(route, repairs->positions[k]);
+  City *lCity = orientedRoad->reversed->dest;
+  City *rCity = orientedRoad->dest;
+  SearchState *forward = worker == 0 ? &(map->search) : &(map->workers[2 * worker - 2]);
+  SearchState *backward = worker == 0 ? &(map->backward) : &(map->workers[2 * worker - 1]);
+  Neigh ***detour = &(repairs->detours[k]);
+  uint32_t *length = &(repairs->lengths[k]);
+
+  bool found;
+  if(repairs->landmarks != NULL){
+    found = findShortestPathEdges(lCity, rCity, &(route->positions), rCity, orientedRoad, &(map->graph), repairs->landmarks, forward, detour, length);
+  } else {
+    found = findDetour(lCity, rCity, &(route->positions), orientedRoad, &(map->graph), forward, backward, detour, length);
+  }
+  return found && *detour != NULL;
+}
 
-  for(int routeId=1; routeId<1000; routeId++){
-    if(neighbour2->localRoutes[routeId] == false) continue;
+static void freeRepairs(Repairs *repairs){
+  for(uint32_t k = 0; repairs->detours != NULL && k < repairs->count; k++) free(repairs->detours[k]);
+  free(repairs->routes);
+  free(repairs->positions);
+  free(repairs->detours);
+  free(repairs->lengths);
+}
 
-    Neigh *orientedRoad = NULL;
-    ListNode *listPtr = map->routes[routeId];
-    ListNode **leftPtr = &(map->routes[routeId]);
-    ListNode *rightPtr = NULL;
+bool removeRoad(Map *map, const char *city1, const char *city2){
+  if(*city1 == 0 || *city2 == 0) return false;
+  if(map == NULL || strcmp(city1, city2) == 0) return false;
 
-    while(listPtr != NULL){
-      rightPtr = listPtr->next;
-      Neigh *road = (Neigh*)(listPtr->valPtr);
-      Neigh *rev = road->reversed;
-      City *first = rev->dest;
-      City *sec = road->dest;
+  City *cityPtr1 = searchCity(map, city1);
+  City *cityPtr2 = searchCity(map, city2);
 
-      if((first == cityPtr1 && sec == cityPtr2) || (first == cityPtr2 && sec == cityPtr1)){
-        orientedRoad = road;
-        break;
-      }
+  if(cityPtr1 == NULL || cityPtr2 == NULL){
+    return false;
+  }
 
-      leftPtr = &(listPtr->next);
-      listPtr = listPtr->next;
-    }
+  Neigh *neighbour2 = searchNeigh(map, cityPtr1, cityPtr2);
+  if(neighbour2 == NULL) return false;
 
-    orientedRoad->forbid = true;
-    orientedRoad->reversed->forbid = true;
-    City *lCity = orientedRoad->reversed->dest;
-    City *rCity = orientedRoad->dest;
+  RouteSet *affected = neighbour2->localRoutes;
+  uint32_t affectedCount = affected == NULL ? 0 : affected->size;
+
+  if(affectedCount > 0){
+    if(!graphSync(&(map->graph), &(map->cities), &(map->roads))) return false;
+
+    Repairs repairs;
+    repairs.map = map;
+    repairs.count = affectedCount;
+    repairs.landmarks = prepareLandmarks(map);
+    repairs.routes = (Route**)malloc(affectedCount * sizeof(Route*));
+    repairs.positions = (uint32_t*)malloc(affectedCount * sizeof(uint32_t));
+    repairs.detours = (Neigh***)calloc(affectedCount, sizeof(Neigh**));
+    repairs.lengths = (uint32_t*)calloc(affectedCount, sizeof(uint32_t));
+    if(repairs.routes == NULL || repairs.positions == NULL || repairs.detours == NULL || repairs.lengths == NULL){
+      freeRepairs(&repairs);
+      return false;
+    }
 
-    ListNode *path = NULL;
-    if(!findShortestPath(lCity, rCity, map->routes[routeId], map->cities, rCity, &path)){
-      free(leftPointers);
-      free(rightPointers);
+    // Miasta usuwanego odcinka sąsiadują na każdej drodze krajowej, która
+    // przez niego przechodzi; odcinek leży na pozycji wcześniejszego z nich.
+    for(uint32_t k = 0; k < affectedCount; k++){
+      Route *route = routeTableFind(&(map->routes), affected->routeIds[k]);
+      uint32_t i1, i2;
+      routeFind(route, cityPtr1, &i1);
+      routeFind(route, cityPtr2, &i2);
+      repairs.routes[k] = route;
+      repairs.positions[k] = i1 < i2 ? i1 : i2;
+    }
 
-      for(int32_t i=0; i<1000; i++){
-        freeList(paths[i]);
-      }
-      free(paths);
-      orientedRoad->forbid = false;
-      orientedRoad->reversed->forbid = false;
+    if(!runParallel(affectedCount, map->workersCount, repairRoute, &repairs)){
+      freeRepairs(&repairs);
       return false;
     }
-    orientedRoad->forbid = false;
-    orientedRoad->reversed->forbid = false;
 
-    if(path == NULL){
-      free(leftPointers);
-      free(rightPointers);
+    for(uint32_t k = 0; k < affectedCount; k++){
+      if(markRoute(map, repairs.detours[k], repairs.lengths[k], repairs.routes[k])) continue;
 
-      for(int32_t i=0; i<1000; i++){
-        freeList(paths[i]);
+      for(uint32_t j = 0; j < k; j++){
+        unmarkRoute(repairs.detours[j], repairs.lengths[j], repairs.routes[j]->id);
       }
-      free(paths);
+      freeRepairs(&repairs);
       return false;
     }
 
-    leftPointers[routeId] = leftPtr;
-    rightPointers[routeId] = rightPtr;
-    paths[routeId] = path;
-  }
-
-  for(int routeId=1; routeId<1000; routeId++){
-    if(neighbour2->localRoutes[routeId] == false) continue;
-
-    ListNode *endOfPath = paths[routeId];
-    while(true){
-      Neigh *road = (Neigh*)(endOfPath->valPtr);
-      road->localRoutes[routeId] = true;
-      road->reversed->localRoutes[routeId] = true;
-      if(endOfPath->next == NULL) break;
-      endOfPath = endOfPath->next;
+    for(uint32_t k = 0; k < affectedCount; k++){
+      routeSplice(repairs.routes[k], repairs.positions[k], repairs.detours[k], repairs.lengths[k]);
     }
-
-    free(*(leftPointers[routeId]));
-    *(leftPointers[routeId]) = paths[routeId];
-    endOfPath->next = rightPointers[routeId];
+    freeRepairs(&repairs);
   }
 
   Neigh *rev = neighbour2->reversed;
-  removeNode(&(cityPtr1->neighbours), neighbour2, 2);
-  removeNode(&(cityPtr2->neighbours), rev, 2);
-  deleteNeigh(neighbour2);
-  deleteNeigh(rev);
-  free(leftPointers);
-  free(rightPointers);
-  free(paths);
+  edgeTableRemove(&(map->roads), neighbour2);
+  graphRemoveEdge(&(map->graph), neighbour2);
+  graphRemoveEdge(&(map->graph), rev);
+  deleteNeigh(&(map->pools), neighbour2);
+  deleteNeigh(&(map->pools), rev);
+  hierarchyInvalidate(&(map->hierarchy));
   return true;
 }
 
@@ -559,19 +776,15 @@ bool checkRoad(Map *map, char const *city1, char const *city2, uint32_t length,
     return false;
   }
 
-  City *cityPtr1 = NULL;
-  City *cityPtr2 = NULL;
-  if(!searchCity(map, (char *)city1, &cityPtr1)) return false;
-  if(!searchCity(map, (char *)city2, &cityPtr2)) return false;
+  City *cityPtr1 = searchCity(map, city1);
+  City *cityPtr2 = searchCity(map, city2);
 
   if(cityPtr1 == NULL || cityPtr2 == NULL){
     *result = 1;
     return true;
   }
 
-  Neigh *neighPtr = NULL;
-  if(!searchNeigh(cityPtr1->neighbours, cityPtr2, &neighPtr)) return false;
-
+  Neigh *neighPtr = searchNeigh(map, cityPtr1, cityPtr2);
   if(neighPtr == NULL){
     *result = 1;
     return true;
@@ -595,9 +808,10 @@ char const *getRouteDescription(Map *map, unsigned routeId){
   if(result == NULL) return NULL;
   *result = 0;
 
-  if(map == NULL || routeId == 0 || routeId > 999) return result;
+  if(map == NULL || routeId == 0) return result;
 
-  if(map->routes[routeId] == NULL) return result;
+  Route *route = routeTableFind(&(map->routes), routeId);
+  if(route == NULL) return result;
 
   char *ptr = result;
   int32_t count = 0;
@@ -608,13 +822,12 @@ char const *getRouteDescription(Map *map, unsigned routeId){
   }
   if(!addChar(&result, &ptr, ';', &count, &bufferSize)) return NULL;
 
-  ListNode *listPtr = map->routes[routeId];
-  char *headName = ((Neigh*)(listPtr->valPtr))->reversed->dest->name;
+  char *headName = routeFirstCity(route)->name;
   if(!appendCityName(&result, &ptr, headName, &count, &bufferSize)) return NULL;
   if(!addChar(&result, &ptr, ';', &count, &bufferSize)) return NULL;
 
-  while(listPtr != NULL){
-    Neigh *actNeigh = (Neigh*)(listPtr->valPtr);
+  for(uint32_t i = 0; i < route->count; i++){
+    Neigh *actNeigh = routeRoad(route, i);
     if(!appendInteger(&result, &ptr, actNeigh->length, &count, &bufferSize)){
       return NULL;
     }
@@ -634,10 +847,9 @@ char const *getRouteDescription(Map *map, unsigned routeId){
     if(!appendCityName(&result, &ptr, actNeigh->dest->name, &count, &bufferSize)){
       return NULL;
     }
-    if(listPtr->next != NULL){
+    if(i + 1 < route->count){
       if(!addChar(&result, &ptr, ';', &count, &bufferSize)) return NULL;
     }
-    listPtr = listPtr->next;
   }
   return result;
 }
@@ -12,6 +12,7 @@
 #include <stdbool.h>
 #include <inttypes.h>
 #include "types.h"
+#include "heap.h"
 
 /**
  * Struktura przechowująca mapę dróg krajowych.
@@ -27,13 +28,17 @@ typedef struct Map Map;
 bool routeExists(Map *map, uint32_t routeId);
 
 /** @brief Dodaje do mapy drogę krajową.
- * Dodaje do mapy drogę krajową podaną w argumencie list, o numerze routeId.
+ * Dodaje do mapy drogę krajową złożoną z podanych kolejno odcinków dróg,
+ * o numerze routeId.
  * Założenie: droga jest poprawna oraz aktualnie nie istnieje droga o danym numerze.
  * @param[in, out] map      - wskaźnik na mapę
  * @param[in] routeId      - numer dodawanej drogi.
- * @param[in] list      - lista structów Neigh, reprezentująca drogę krajową
+ * @param[in] roads      - tablica odcinków (Neigh) skierowanych zgodnie z drogą krajową
+ * @param[in] count      - liczba odcinków
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się
+ * zaalokować pamięci (wtedy mapa nie jest zmieniana).
  */
-void setRoute(Map *map, uint32_t routeId, ListNode *list);
+bool setRoute(Map *map, uint32_t routeId, Neigh **roads, uint32_t count);
 
 /** @brief Tworzy nową strukturę.
  * Tworzy nową, pustą strukturę niezawierającą żadnych miast, odcinków dróg ani
@@ -50,6 +55,48 @@ Map* newMap(void);
  */
 void deleteMap(Map *map);
 
+/** @brief Wybiera kolejkę priorytetową używaną przy wyszukiwaniu ścieżek.
+ * Domyślnie używany jest kopiec czwórkowy. Wybór nie wpływa na wyniki
+ * operacji, a jedynie na czas ich wykonania.
+ * @param[in, out] map      - wskaźnik na mapę
+ * @param[in] kind      - rodzaj kolejki
+ */
+void setQueueKind(Map *map, QueueKind kind);
+
+/** @brief Włącza wyszukiwanie A* z punktami orientacyjnymi.
+ * Dla podanej liczby punktów orientacyjnych mapa przechowuje odległości od nich
+ * do wszystkich miast i używa ich do kierowania wyszukiwania w stronę celu.
+ * Tablice są przeliczane leniwie po zmianach sieci dróg. Wybór nie wpływa na
+ * wyniki operacji, a jedynie na czas ich wykonania.
+ * @param[in, out] map      - wskaźnik na mapę
+ * @param[in] count      - liczba punktów orientacyjnych (0 wyłącza A*)
+ */
+void setLandmarks(Map *map, uint32_t count);
+
+/** @brief Włącza wyszukiwanie z użyciem hierarchii kontrakcyjnej.
+ * Mapa buduje hierarchię przy pierwszym wyszukiwaniu i używa jej w newRoute
+ * oraz extendRoute, przechodząc na zwykłe wyszukiwanie, gdy wynik mógłby być
+ * niejednoznaczny. Po dodaniu lub usunięciu odcinka hierarchia jest
+ * przebudowywana dopiero wtedy, gdy wyszukiwania bez niej kosztowały więcej
+ * niż jej poprzednia budowa. Wybór nie wpływa na wyniki operacji, a jedynie
+ * na czas ich wykonania.
+ * @param[in, out] map      - wskaźnik na mapę
+ * @param[in] enabled      - informacja, czy używać hierarchii
+ */
+void setHierarchy(Map *map, bool enabled);
+
+/** @brief Ustala liczbę wątków wyszukujących objazdy w removeRoad.
+ * Objazdy dróg krajowych przechodzących przez usuwany odcinek są wyszukiwane
+ * jednocześnie, każdy wątek z własnym stanem wyszukiwania. Domyślnie używany
+ * jest jeden wątek. Wybór nie wpływa na wyniki operacji, a jedynie na czas
+ * ich wykonania.
+ * @param[in, out] map      - wskaźnik na mapę
+ * @param[in] count      - liczba wątków
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się
+ * zaalokować pamięci (mapa używa wtedy jednego wątku).
+ */
+bool setWorkers(Map *map, uint32_t count);
+
 /** @brief Wyszukuje odcinek drogi między dwoma miastami (Neigh), i zapisuje w
  * strukturze wskazywanej przez target.
  * @param[in] map      - wskaźnik na mapę
@@ -113,6 +160,22 @@ bool repairRoad(Map *map, const char *city1, const char *city2, int repairYear);
 bool newRoute(Map *map, unsigned routeId,
               const char *city1, const char *city2);
 
+/** @brief Tworzy wiele dróg krajowych o wspólnym mieście początkowym.
+ * Każda droga jest wyznaczana tak jak w @ref newRoute, z miastem @p city jako
+ * pierwszym miastem, ale wszystkie są odczytywane z jednego wyszukiwania od
+ * tego miasta. Drogi są tworzone wszystkie albo żadna.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] city       – wskaźnik na napis reprezentujący nazwę wspólnego miasta;
+ * @param[in] count      – liczba tworzonych dróg krajowych;
+ * @param[in] routeIds   – tablica numerów tworzonych dróg krajowych;
+ * @param[in] cities     – tablica nazw miast, w których kończą się kolejne drogi.
+ * @return Wartość @p true, jeśli wszystkie drogi krajowe zostały utworzone.
+ * Wartość @p false, jeśli dla którejś z dróg wystąpiłby błąd w @ref newRoute,
+ * numery dróg się powtarzają, @p count jest równe zero lub nie udało się
+ * zaalokować pamięci; wtedy mapa nie jest zmieniana.
+ */
+bool newRoutes(Map *map, const char *city, uint32_t count, const unsigned *routeIds, const char **cities);
+
 /** @brief Wydłuża drogę krajową do podanego miasta.
  * Dodaje do drogi krajowej nowe odcinki dróg do podanego miasta w taki sposób,
  * aby nowy fragment drogi krajowej był najkrótszy. Jeśli jest więcej niż jeden
@@ -132,6 +195,22 @@ bool newRoute(Map *map, unsigned routeId,
  */
 bool extendRoute(Map *map, unsigned routeId, const char *city);
 
+/** @brief Wyznacza odległość między dwoma różnymi miastami.
+ * Nie tworzy drogi krajowej ani nie zmienia mapy. Jeśli mapa używa hierarchii
+ * kontrakcyjnej, odpowiedź jest wyznaczana z niej.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] city1      – wskaźnik na napis reprezentujący nazwę miasta;
+ * @param[in] city2      – wskaźnik na napis reprezentujący nazwę miasta;
+ * @param[out] length    – długość najkrótszej ścieżki między miastami;
+ * @param[out] year      – najmłodszy spośród najstarszych odcinków na
+ * najkrótszych ścieżkach (rok budowy lub ostatniego remontu).
+ * @return Wartość @p true, jeśli odległość została wyznaczona.
+ * Wartość @p false, jeśli wystąpił błąd: któryś z parametrów ma niepoprawną
+ * wartość, któreś z podanych miast nie istnieje, obie podane nazwy miast są
+ * identyczne, miasta nie są połączone lub nie udało się zaalokować pamięci.
+ */
+bool routeDistance(Map *map, const char *city1, const char *city2, uint64_t *length, int32_t *year);
+
 /** @brief Usuwa odcinek drogi między dwoma różnymi miastami.
  * Usuwa odcinek drogi między dwoma miastami. Jeśli usunięcie tego odcinka drogi
  * powoduje przerwanie ciągu jakiejś drogi krajowej, to uzupełnia ją
@@ -1,10 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <string.h>
 #include "types.h"
 #include "tools.h"
 #include "parser.h"
 #include "map.h"
+#include "hash.h"
+#include "pool.h"
 
 extern int32_t ERROR;
 extern int32_t IGNORE;
@@ -12,20 +15,248 @@ extern int32_t ADD;
 extern int32_t REPAIR;
 extern int32_t DESCR;
 extern int32_t CREATE;
+extern int32_t DIST;
+extern int32_t BATCH;
 
-void free_ptrs(Info *info){
-  free(info->args);
-  info->args = NULL;
-  free(info->beg);
+void clearInfo(Info *info){
+  info->size = 0;
   info->beg = NULL;
 }
 
 void callError(Info *info, int32_t line){
-  free_ptrs(info);
+  clearInfo(info);
   fprintf(stderr, "ERROR %d\n", line);
 }
 
-int32_t main(){
+/**
+ * Odcinek gromadzonej drogi krajowej.
+ */
+typedef struct DraftRoad {
+  /*@{*/
+  char const *city; /**< miasto, do którego prowadzi odcinek */
+  uint32_t length; /**< długość odcinka */
+  int32_t year; /**< rok budowy lub ostatniego remontu */
+  /*@}*/
+} DraftRoad;
+
+/**
+ * Droga krajowa z polecenia jej utworzenia, gromadzona odcinek po odcinku.
+ * Mapa jest zmieniana dopiero w draftCommit, więc polecenie jest wykonywane
+ * w całości albo wcale.
+ */
+typedef struct RouteDraft {
+  /*@{*/
+  uint32_t routeId; /**< numer drogi krajowej */
+  bool isBad; /**< informacja, czy polecenie jest już wiadomo niepoprawne */
+  bool copyNames; /**< informacja, czy nazwy miast trzeba kopiować (bo linia nie jest trzymana w całości) */
+  char const *first; /**< pierwsze miasto drogi */
+  char const *last; /**< ostatnie dotąd miasto drogi */
+  DraftRoad *roads; /**< kolejne odcinki */
+  uint32_t count; /**< liczba odcinków */
+  uint32_t capacity; /**< rozmiar tablicy roads */
+  NameSet cities; /**< nazwy miast drogi, do wykrywania powtórzeń */
+  Arena names; /**< bloki ze skopiowanymi nazwami miast */
+  /*@}*/
+} RouteDraft;
+
+void draftInit(RouteDraft *draft){
+  draft->routeId = 0;
+  draft->isBad = false;
+  draft->copyNames = false;
+  draft->first = NULL;
+  draft->last = NULL;
+  draft->roads = NULL;
+  draft->count = 0;
+  draft->capacity = 0;
+  nameSetInit(&(draft->cities));
+  arenaInit(&(draft->names));
+}
+
+void draftClear(RouteDraft *draft){
+  free(draft->roads);
+  nameSetFree(&(draft->cities));
+  arenaDestroy(&(draft->names));
+  draftInit(draft);
+}
+
+// Dodaje miasto do drogi; zwraca nazwę, której można używać do końca
+// polecenia, lub NULL, jeśli nie udało się zaalokować pamięci. Kopie nazw są
+// układane w arenie jedna za drugą, bez wyrównania.
+char const *draftCity(RouteDraft *draft, char const *name){
+  if(!nameSetReserve(&(draft->cities), 1)) return NULL;
+
+  if(draft->copyNames){
+    size_t size = strlen(name) + 1;
+    char *copy = (char*)arenaAllocUnaligned(&(draft->names), size);
+    if(copy == NULL) return NULL;
+    memcpy(copy, name, size);
+    name = copy;
+  }
+
+  nameSetAdd(&(draft->cities), name);
+  return name;
+}
+
+void draftStart(Map *m, RouteDraft *draft, uint32_t routeId, char const *city, bool copyNames){
+  draft->routeId = routeId;
+  draft->copyNames = copyNames;
+  if(routeId == 0 || routeExists(m, routeId)){
+    draft->isBad = true;
+    return;
+  }
+
+  draft->first = draftCity(draft, city);
+  draft->last = draft->first;
+  if(draft->first == NULL) draft->isBad = true;
+}
+
+void draftRoad(Map *m, RouteDraft *draft, uint32_t length, int32_t year, char const *city){
+  if(draft->isBad) return;
+
+  int32_t result;
+  if(nameSetHas(&(draft->cities), city) || !checkRoad(m, draft->last, city, length, year, &result)){
+    draft->isBad = true;
+    return;
+  }
+
+  if(draft->count == draft->capacity){
+    uint32_t capacity = draft->capacity == 0 ? 16 : 2 * draft->capacity;
+    DraftRoad *roads = (DraftRoad*)realloc(draft->roads, capacity * sizeof(DraftRoad));
+    if(roads == NULL){
+      draft->isBad = true;
+      return;
+    }
+    draft->roads = roads;
+    draft->capacity = capacity;
+  }
+
+  char const *name = draftCity(draft, city);
+  if(name == NULL){
+    draft->isBad = true;
+    return;
+  }
+
+  DraftRoad *road = &(draft->roads[draft->count]);
+  road->city = name;
+  road->length = length;
+  road->year = year;
+  draft->count++;
+  draft->last = name;
+}
+
+// Dodaje i remontuje odcinki drogi, a potem tworzy z nich drogę krajową.
+// Wcześniejsze odcinki łączą inne pary miast, więc checkRoad daje ten sam
+// wynik co przy gromadzeniu drogi.
+bool draftCommit(Map *m, RouteDraft *draft){
+  if(draft->isBad || draft->count == 0) return false;
+
+  Neigh **roads = (Neigh**)malloc(draft->count * sizeof(Neigh*));
+  if(roads == NULL) return false;
+
+  char const *from = draft->first;
+  for(uint32_t i = 0; i < draft->count; i++){
+    DraftRoad *road = &(draft->roads[i]);
+    int32_t result = 0;
+    checkRoad(m, from, road->city, road->length, road->year, &result);
+    if(result == 1){
+      addRoad(m, from, road->city, road->length, road->year);
+    }
+    if(result == 2){
+      repairRoad(m, from, road->city, road->year);
+    }
+
+    searchRoad(m, from, road->city, &roads[i]);
+    from = road->city;
+  }
+
+  bool isSet = setRoute(m, draft->routeId, roads, draft->count);
+  free(roads);
+  return isSet;
+}
+
+// Czyta polami długą definicję drogi krajowej. Zwraca false tylko wtedy, gdy
+// nie udało się zaalokować bufora wejścia; valid mówi, czy linia była poprawna.
+bool readRoute(Map *m, Input *input, Info *field, RouteDraft *draft, bool *valid, bool *last){
+  bool lineEnd = false;
+  bool isBad = false;
+  uint32_t k = 0;
+  uint32_t routeId = 0;
+  uint32_t length = 0;
+  int32_t year = 0;
+
+  while(!lineEnd){
+    if(!readField(input, field, &lineEnd, last)) return false;
+
+    if(!isBad){
+      if(k == 0){
+        isBad = !isUnsignedField(field, 0);
+        routeId = (uint32_t)field->values[0];
+      } else if(k == 1){
+        isBad = !field->alph[0];
+        if(!isBad) draftStart(m, draft, routeId, field->args[0], true);
+      } else if((k-2)%3 == 0){
+        isBad = !isUnsignedField(field, 0);
+        length = (uint32_t)field->values[0];
+      } else if((k-2)%3 == 1){
+        isBad = !isSignedField(field, 0);
+        year = (int32_t)field->values[0];
+      } else {
+        isBad = !field->alph[0];
+        if(!isBad) draftRoad(m, draft, length, year, field->args[0]);
+      }
+    }
+    k++;
+  }
+
+  *valid = !isBad && k >= 5 && (k-2)%3 == 0;
+  return true;
+}
+
+/** Odczytuje opcje wywołania: "-q heap" lub "-q radix" wybiera kolejkę
+ * priorytetową wyszukiwania ścieżek, "-l N" włącza A* z N punktami
+ * orientacyjnymi, "-c" włącza hierarchię kontrakcyjną, a "-t N" ustala
+ * liczbę wątków wyszukujących objazdy w removeRoad. */
+bool readOptions(int argc, char **argv, QueueKind *kind, uint32_t *landmarks, bool *hierarchy, uint32_t *workers){
+  for(int32_t i = 1; i < argc; i++){
+    if(strcmp(argv[i], "-c") == 0){
+      *hierarchy = true;
+      continue;
+    }
+    if(i + 1 >= argc) return false;
+    char *value = argv[i + 1];
+
+    if(strcmp(argv[i], "-q") == 0){
+      if(strcmp(value, "heap") == 0) *kind = QUEUE_HEAP;
+      else if(strcmp(value, "radix") == 0) *kind = QUEUE_RADIX;
+      else return false;
+    } else if(strcmp(argv[i], "-l") == 0){
+      char *end;
+      unsigned long count = strtoul(value, &end, 10);
+      if(*value < '0' || *value > '9' || *end != 0 || count > 64) return false;
+      *landmarks = (uint32_t)count;
+    } else if(strcmp(argv[i], "-t") == 0){
+      char *end;
+      unsigned long count = strtoul(value, &end, 10);
+      if(*value < '0' || *value > '9' || *end != 0 || count < 1 || count > 64) return false;
+      *workers = (uint32_t)count;
+    } else {
+      return false;
+    }
+    i++;
+  }
+  return true;
+}
+
+int32_t main(int argc, char **argv){
+  QueueKind kind = QUEUE_HEAP;
+  uint32_t landmarks = 0;
+  bool hierarchy = false;
+  uint32_t workers = 1;
+  if(!readOptions(argc, argv, &kind, &landmarks, &hierarchy, &workers)){
+    fprintf(stderr, "usage: %s [-q heap|radix] [-l landmarks] [-c] [-t threads]\n", argv[0]);
+    exit(1);
+  }
+
   Info *info = createInfo();
   if(info == NULL){
     exit(1);
@@ -33,7 +264,27 @@ int32_t main(){
 
   Map *m = newMap();
   if(m == NULL){
-    free(info);
+    deleteInfo(info);
+    exit(1);
+  }
+  setQueueKind(m, kind);
+  setLandmarks(m, landmarks);
+  setHierarchy(m, hierarchy);
+  if(!setWorkers(m, workers)){
+    deleteInfo(info);
+    deleteMap(m);
+    exit(1);
+  }
+
+  Input input;
+  inputInit(&input, stdin);
+
+  Info *field = createInfo();
+  RouteDraft draft;
+  draftInit(&draft);
+  if(field == NULL){
+    deleteInfo(info);
+    deleteMap(m);
     exit(1);
   }
 
@@ -42,24 +293,50 @@ int32_t main(){
     line++;
 
     char *s = NULL;
-    if(!readLine(&s)){
-      free(info);
+    bool last;
+    bool longRoute;
+    if(!readLine(&input, &s, &last, &longRoute)){
+      inputFree(&input);
+      deleteInfo(info);
+      deleteInfo(field);
       deleteMap(m);
       exit(1);
     }
 
+    if(longRoute){
+      bool valid;
+      if(!readRoute(m, &input, field, &draft, &valid, &last)){
+        draftClear(&draft);
+        inputFree(&input);
+        deleteInfo(info);
+        deleteInfo(field);
+        deleteMap(m);
+        exit(1);
+      }
+
+      if(last){
+        draftClear(&draft);
+        callError(info, line);
+        break;
+      }
+      if(!valid || !draftCommit(m, &draft)) callError(info, line);
+      draftClear(&draft);
+      continue;
+    }
+
     if(!whatToDo(s, info)){
-      free(s);
-      free(info);
+      inputFree(&input);
+      deleteInfo(info);
+      deleteInfo(field);
       deleteMap(m);
       exit(1);
     }
 
-    if(feof(stdin)){
+    if(last){
       if(info->code != IGNORE) {
         fprintf(stderr, "ERROR %d\n", line);
       }
-      free_ptrs(info);
+      clearInfo(info);
       break;
     }
 
@@ -69,143 +346,89 @@ int32_t main(){
     }
 
     if(info->code == IGNORE){
-      free_ptrs(info);
+      clearInfo(info);
       continue;
     }
 
     if(info->code == ADD){
-      uint32_t length;
-      int32_t year;
-      toUnsigned(info->args[3], &length);
-      toSigned(info->args[4], &year);
+      uint32_t length = (uint32_t)info->values[3];
+      int32_t year = (int32_t)info->values[4];
 
       if(addRoad(m, info->args[1], info->args[2], length, year)){
-        free_ptrs(info);
+        clearInfo(info);
       } else callError(info, line);
       continue;
     }
 
     if(info->code == REPAIR){
-      int32_t year;
-      toSigned(info->args[3], &year);
+      int32_t year = (int32_t)info->values[3];
       if(repairRoad(m, info->args[1], info->args[2], year)){
-        free_ptrs(info);
+        clearInfo(info);
       } else callError(info, line);
       continue;
     }
 
     if(info->code == DESCR){
-      uint32_t routeId;
-      toUnsigned(info->args[1], &routeId);
+      uint32_t routeId = (uint32_t)info->values[1];
 
       char const *s = getRouteDescription(m, routeId);
       if(s != NULL){
         printf("%s\n", s);
-        free_ptrs(info);
+        clearInfo(info);
 	      free((char*)s);
       } else callError(info, line);
       continue;
     }
 
-    if(info->code == CREATE){
-      TreapNode *treap = NULL;
-      uint32_t routeId;
-      toUnsigned(info->args[0], &routeId);
-
-      if(routeId == 0 || routeId > 999 || routeExists(m, routeId)){
-        callError(info, line);
-        continue;
-      }
-
-      int32_t roads_count = (info->size - 2)/3;
-      int32_t *roads_info = (int32_t*)malloc(roads_count * sizeof(int32_t));
-      if(roads_info == NULL){
-        callError(info, line);
-        continue;
-      }
-
-      if(!insert(&treap, (char*)info->args[1], 4)){
-        free(roads_info);
-        callError(info, line);
-        continue;
-      }
+    if(info->code == DIST){
+      uint64_t length;
+      int32_t year;
+      if(routeDistance(m, info->args[1], info->args[2], &length, &year)){
+        printf("%" PRIu64 ";%" PRId32 "\n", length, year);
+        clearInfo(info);
+      } else callError(info, line);
+      continue;
+    }
 
-      int32_t i = 1;
-      int32_t road_i = 0;
-      bool isBad = false;
-
-      while(i < info->size - 1){
-        char const *search_res = (char const *)search(treap, (char*)info->args[i+3], 4);
-        if(search_res != NULL){
-          isBad = true;
-          break;
-        }
-
-        uint32_t length;
-        int32_t year;
-        toUnsigned(info->args[i+1], &length);
-        toSigned(info->args[i+2], &year);
-
-        if(!checkRoad(m, info->args[i], info->args[i+3], length, year, &roads_info[road_i])){
-          isBad = true;
-          break;
-        }
-        if(!insert(&treap, (char*)info->args[i+3], 4)){
-          isBad = true;
-          break;
-        }
-
-        i += 3;
-        road_i++;
-      }
-      flat_deleteTreap(treap);
+    if(info->code == BATCH){
+      uint32_t count = (info->size - 2)/2;
+      unsigned *routeIds = (unsigned*)malloc(count * sizeof(unsigned));
+      char const **cities = (char const**)malloc(count * sizeof(char const*));
+      bool ok = routeIds != NULL && cities != NULL;
 
-      if(isBad){
-        free(roads_info);
-        callError(info, line);
-        continue;
+      for(uint32_t k = 0; ok && k < count; k++){
+        routeIds[k] = (unsigned)info->values[2*k + 2];
+        cities[k] = info->args[2*k + 3];
       }
+      ok = ok && newRoutes(m, info->args[1], count, routeIds, cities);
+      free(routeIds);
+      free(cities);
 
-      ListNode *list = NULL;
-      ListNode **ptr = &list;
-
-      i = 1;
-      road_i = 0;
-
-      while(i < info->size - 1){
-        uint32_t length;
-        int32_t year;
-        toUnsigned(info->args[i+1], &length);
-        toSigned(info->args[i+2], &year);
-
-        if(roads_info[road_i] == 1){
-          addRoad(m, info->args[i], info->args[i+3], length, year);
-        }
-        if(roads_info[road_i] == 2){
-          repairRoad(m, info->args[i], info->args[i+3], year);
-        }
-
-        Neigh *road = NULL;
-        searchRoad(m, info->args[i], info->args[i+3], &road);
-
-        ListNode *newPtr = createListNode(road);
-        *ptr = newPtr;
-        ptr = &(newPtr->next);
+      if(ok){
+        clearInfo(info);
+      } else callError(info, line);
+      continue;
+    }
 
-        i += 3;
-        road_i++;
+    if(info->code == CREATE){
+      draftStart(m, &draft, (uint32_t)info->values[0], info->args[1], false);
+      for(int32_t i = 2; i < info->size; i += 3){
+        draftRoad(m, &draft, (uint32_t)info->values[i], (int32_t)info->values[i+1], info->args[i+2]);
       }
 
-      setRoute(m, routeId, list);
-      free(roads_info);
-      free_ptrs(info);
+      if(draftCommit(m, &draft)){
+        clearInfo(info);
+      } else callError(info, line);
+      draftClear(&draft);
       continue;
     }
 
-    free_ptrs(info);
+    clearInfo(info);
   }
 
-  free(info);
+  inputFree(&input);
+  deleteInfo(info);
+  deleteInfo(field);
   deleteMap(m);
   m = NULL;
 
@@ -1,9 +1,15 @@
+// read i fileno pochodzą z POSIX.
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <inttypes.h>
+#include <errno.h>
+#include <unistd.h>
 #include "parser.h"
+#include "scan.h"
 
 int32_t ERROR = -2;
 int32_t IGNORE = -1;
@@ -11,326 +17,359 @@ int32_t ADD = 0;
 int32_t REPAIR = 1;
 int32_t DESCR = 2;
 int32_t CREATE = 3;
+int32_t DIST = 4;
+int32_t BATCH = 5;
 
 char const *_add = "addRoad";
 char const *_repair = "repairRoad";
 char const *_descr = "getRouteDescription";
+char const *_dist = "routeDistance";
+char const *_batch = "newRoutes";
 
 uint64_t unsigned_MAX = 4294967295;
 int64_t int_MAX = 2147483647;
 
+/** Rozmiar bloku, w jakim wczytywane jest wejście. */
+static const size_t INPUT_BLOCK = 1 << 16;
+
+/** Długość, od której definicja drogi krajowej jest czytana polami. */
+static const size_t STREAM_LINE = 1 << 20;
+
+/** Początkowa liczba pól, na jaką struktura Info ma miejsce. */
+static const uint32_t INITIAL_FIELDS = 8;
+
 Info *createInfo(){
   Info *new = (Info*)malloc(sizeof(Info));
   if(new == NULL) return NULL;
   new->code = -2;
+  new->size = 0;
+  new->capacity = 0;
   new->args = NULL;
+  new->values = NULL;
+  new->num = NULL;
+  new->alph = NULL;
   new->beg = NULL;
-  new->size = 0;
 
   return new;
 }
 
-void writeInfo(int32_t code, char const **args, int32_t size, Info *dest, char *beg){
-  dest->code = code;
-  dest->args = args;
-  dest->size = size;
-  dest->beg = beg;
+void deleteInfo(Info *info){
+  if(info == NULL) return;
+  free(info->args);
+  free(info->values);
+  free(info->num);
+  free(info->alph);
+  free(info);
+}
+
+// Podwaja tablice pól; po niepowodzeniu dotychczasowa pojemność pozostaje ważna.
+static bool growInfo(Info *info){
+  uint32_t capacity = info->capacity == 0 ? INITIAL_FIELDS : 2 * info->capacity;
+
+  char const **args = (char const**)realloc(info->args, capacity * sizeof(char const*));
+  if(args == NULL) return false;
+  info->args = args;
+
+  int64_t *values = (int64_t*)realloc(info->values, capacity * sizeof(int64_t));
+  if(values == NULL) return false;
+  info->values = values;
+
+  bool *num = (bool*)realloc(info->num, capacity * sizeof(bool));
+  if(num == NULL) return false;
+  info->num = num;
+
+  bool *alph = (bool*)realloc(info->alph, capacity * sizeof(bool));
+  if(alph == NULL) return false;
+  info->alph = alph;
+
+  info->capacity = capacity;
+  return true;
+}
+
+void inputInit(Input *input, FILE *file){
+  input->file = file;
+  input->buffer = NULL;
+  input->capacity = 0;
+  input->begin = 0;
+  input->end = 0;
+  input->eof = false;
 }
 
-bool readLine(char **dest) {
-  uint32_t buffer_size = 10;
-  uint32_t counter = 0;
+void inputFree(Input *input){
+  free(input->buffer);
+  inputInit(input, input->file);
+}
+
+// Przesuwa nieprzeczytaną część bufora na jego początek i dopisuje za nią
+// kolejny blok pliku; bufor rośnie, gdy linia go wypełnia. Czyta przez read,
+// które zwraca to, co już jest dostępne, więc na potoku lub terminalu linia
+// jest przetwarzana od razu, a nie dopiero po zapełnieniu całego bloku.
+static bool inputFill(Input *input){
+  if(input->begin > 0){
+    memmove(input->buffer, input->buffer + input->begin, input->end - input->begin);
+    input->end -= input->begin;
+    input->begin = 0;
+  }
+
+  // Jedno miejsce jest zawsze zostawiane na znak kończący ostatnią linię.
+  if(input->capacity - input->end < INPUT_BLOCK / 2 + 1){
+    size_t capacity = input->capacity == 0 ? INPUT_BLOCK : 2 * input->capacity;
+    char *buffer = (char*)realloc(input->buffer, capacity);
+    if(buffer == NULL) return false;
+    input->buffer = buffer;
+    input->capacity = capacity;
+  }
+
+  ssize_t count;
+  do {
+    count = read(fileno(input->file), input->buffer + input->end, input->capacity - input->end - 1);
+  } while(count < 0 && errno == EINTR);
 
-  char *str = (char*)malloc(buffer_size);
-  if(str == NULL) exit(1);
-  char *ptr = str;
+  if(count <= 0) input->eof = true;
+  else input->end += (size_t)count;
+  return true;
+}
 
+bool readLine(Input *input, char **dest, bool *last, bool *longRoute) {
+  size_t scanned = 0;
+  char *newline = NULL;
   bool isBad = 0;
-  bool isFirst = 1;
-  bool ignore = 0;
+  *last = false;
+  *longRoute = false;
 
+  // Jedno przejście szuka zarazem końca linii i znaków sterujących, bo znak
+  // nowej linii też jest znakiem sterującym.
   while (1) {
-    if (counter == buffer_size - 1) {
-      buffer_size *= 2;
-      char *old = str;
-      str = (char*)realloc(str, buffer_size);
-      if(str == NULL){
-        free(old);
-        *dest = NULL;
-        return false;
+    char *from = input->buffer + input->begin;
+    size_t available = input->end - input->begin;
+    while (scanned < available) {
+      scanned += scanControl(from + scanned, available - scanned);
+      if (scanned == available) break;
+      if (from[scanned] == 10) {
+        newline = from + scanned;
+        break;
       }
-      ptr = str + counter;
+      isBad = 1;
+      scanned++;
     }
+    if (newline != NULL) break;
 
-    *ptr = fgetc(stdin);
+    // Długa linia zaczynająca się od cyfry może być tylko definicją drogi
+    // krajowej; jest wtedy czytana polami, bez wczytywania jej w całości.
+    if (scanned >= STREAM_LINE && *from >= '0' && *from <= '9') {
+      *longRoute = true;
+      *dest = NULL;
+      return true;
+    }
 
-    if (feof(stdin)) {
+    if (input->eof) {
+      *last = true;
       break;
     }
-
-    if (isFirst) {
-      if (*ptr == '#') ignore = 1;
-      isFirst = 0;
+    if (!inputFill(input)) {
+      *dest = NULL;
+      return false;
     }
-
-    if (*ptr == 10) break;
-    if (*ptr <= 31 && *ptr >= 0) isBad = 1;
-
-    counter++;
-    ptr++;
   }
 
-  if (isBad && !ignore) {
-    free(str);
+  char *str = input->buffer + input->begin;
+  size_t length = newline != NULL ? (size_t)(newline - str) : input->end - input->begin;
+  str[length] = 0;
+  input->begin += newline != NULL ? length + 1 : length;
+
+  if (isBad && *str != '#') {
     *dest = NULL;
     return true;
   }
 
-  *ptr = 0;
   *dest = str;
   return true;
 }
 
-char const *extract(char *s, uint32_t *curr_dist, bool *isNumber, bool *alphCheck) {
-  char *ptr = s;
-  *curr_dist = 0;
-  *isNumber = 1;
-  *alphCheck = 1;
-  bool isFirst = true;
+// Wydziela k-te pole linii, zastępując kończący je średnik zerem, i od razu
+// wyznacza jego wartość, jeśli jest liczbą. Zwraca długość pola.
+static uint32_t extract(char *s, uint32_t length, Info *dest, int32_t k) {
+  // Minus jest dopuszczalny tylko na początku liczby.
+  uint32_t sign = *s == '-' ? 1 : 0;
+  size_t nonDigit;
+  size_t end = sign + scanField(s + sign, length - sign, &nonDigit);
+  bool isNumber = sign + nonDigit == end;
+  bool alphCheck = 1;
+
+  while (s[end] != 0 && s[end] != ';') {
+    alphCheck = 0;
+    end++;
+    end += scanField(s + end, length - end, &nonDigit);
+  }
 
-  while (1) {
-    if (*ptr == 0 || *ptr == ';') break;
-    if (*ptr <= 31 && *ptr >= 0) *alphCheck = 0;
-    if(isFirst){
-      if ((*ptr < '0' || *ptr > '9') && *ptr != '-') *isNumber = 0;
-      isFirst = false;
-    }
-    else if (*ptr < '0' || *ptr > '9') *isNumber = 0;
-    (*curr_dist)++;
-    ptr++;
+  // Wartość poza zakresem unsigned nie jest dalej liczona, bo i tak jest
+  // niepoprawna.
+  int64_t value = 0;
+  for (size_t i = sign; isNumber && i < end && value <= (int64_t)unsigned_MAX; i++) {
+    value = 10 * value + s[i] - '0';
   }
 
-  *ptr = 0;
-  return s;
+  s[end] = 0;
+  dest->args[k] = s;
+  dest->values[k] = sign ? -value : value;
+  dest->num[k] = isNumber;
+  dest->alph[k] = alphCheck;
+  return end;
 }
 
-bool toUnsigned(char const *s, uint32_t *dest){
-  if(*s == '-' || *s == 0) return false;
-  int32_t len = strlen(s);
-  uint32_t result = 0;
+bool readField(Input *input, Info *dest, bool *lineEnd, bool *last){
+  dest->size = 0;
+  *lineEnd = false;
+  *last = false;
+  if (dest->capacity == 0 && !growInfo(dest)) return false;
 
-  for(int32_t i = 0; i < len; i++){
-    uint64_t new_val = 10 * (uint64_t)result + s[i] - '0';
-    if(new_val > unsigned_MAX) return false;
-    result = (uint32_t)new_val;
-  }
-  *dest = result;
-  return true;
-}
+  size_t scanned = 0;
+  bool found = false;
+  bool control = false;
 
-bool toSigned(char const *s, int32_t *dest){
-  bool neg = false;
-  if(*s == '-'){
-    neg = true;
-    s++;
-  }
-  if(*s == 0) return false;
-  int32_t len = strlen(s);
-  int32_t result = 0;
-
-  for(int32_t i = 0; i < len; i++){
-    int64_t new_val = 10 * (int64_t)result + s[i] - '0';
-    if(!neg && new_val > int_MAX) return false;
-    if(neg && new_val > int_MAX + 1) return false;
-    result = (int32_t)new_val;
+  while (1) {
+    char *from = input->buffer + input->begin;
+    size_t available = input->end - input->begin;
+    while (scanned < available) {
+      size_t nonDigit;
+      scanned += scanField(from + scanned, available - scanned, &nonDigit);
+      if (scanned == available) break;
+      if (from[scanned] == ';' || from[scanned] == 10) {
+        found = true;
+        break;
+      }
+      control = true;
+      scanned++;
+    }
+    if (found) break;
+
+    if (input->eof) {
+      *lineEnd = true;
+      *last = true;
+      break;
+    }
+    if (!inputFill(input)) return false;
   }
 
-  if(neg) result = -result;
-  *dest = result;
+  char *s = input->buffer + input->begin;
+  if (found && s[scanned] == 10) *lineEnd = true;
+  input->begin += found ? scanned + 1 : scanned;
+  s[scanned] = 0;
+
+  extract(s, scanned, dest, 0);
+  dest->size = 1;
+  // Znak sterujący (także zero) czyni pole niepoprawnym zarówno jako nazwę,
+  // jak i jako liczbę.
+  if (control) {
+    dest->num[0] = false;
+    dest->alph[0] = false;
+  }
   return true;
 }
 
-void free_args(void *tab1, void *tab2){
-  free(tab1);
-  free(tab2);
+bool isUnsignedField(Info *info, int32_t k){
+  char const *s = info->args[k];
+  return info->num[k] && *s != '-' && *s != 0 && info->values[k] <= (int64_t)unsigned_MAX;
 }
 
-bool whatToDo(char *s, Info *dest){
-  if(s == NULL){
-    writeInfo(ERROR, NULL, 0, dest, s);
-    return true;
-  }
+bool isSignedField(Info *info, int32_t k){
+  char const *s = info->args[k];
+  if(*s == '-') s++;
+  return info->num[k] && *s != 0 && info->values[k] >= -int_MAX - 1 && info->values[k] <= int_MAX;
+}
 
-  if(*s == '#' || *s == 0){
-    writeInfo(IGNORE, NULL, 0, dest, s);
-    return true;
+// Rozpoznaje polecenie po długości nazwy; nazwy poleceń mają różne długości,
+// więc wystarcza jedno porównanie.
+static int32_t commandCode(char const *s, uint32_t length){
+  char const *keyword;
+  int32_t code;
+  switch(length){
+    case 7: keyword = _add; code = ADD; break;
+    case 9: keyword = _batch; code = BATCH; break;
+    case 10: keyword = _repair; code = REPAIR; break;
+    case 13: keyword = _dist; code = DIST; break;
+    case 19: keyword = _descr; code = DESCR; break;
+    default: return ERROR;
   }
+  return memcmp(s, keyword, length) == 0 ? code : ERROR;
+}
 
-  uint32_t buffer_size = 5;
-  uint32_t size = 0;
-  char const **args = (char const**)malloc(buffer_size * sizeof(char const*));
-  if(args == NULL) return false;
+// Sprawdza poprawność pól linii i zwraca kod polecenia.
+static int32_t classify(Info *info, uint32_t firstLength){
+  int32_t size = info->size;
+  bool *alph = info->alph;
 
-  bool *num = (bool*)malloc(buffer_size * sizeof(bool));
-  if(num == NULL){
-    free(args);
-    return false;
-  }
+  if(info->num[0]){
+    if(size < 3 || !isUnsignedField(info, 0) || !alph[1] || (size-2)%3 != 0) return ERROR;
 
-  bool *alph = (bool*)malloc(buffer_size * sizeof(bool));
-  if(alph == NULL){
-    free(args);
-    free(num);
-    return false;
+    for(int32_t id = 2; id < size; id += 3){
+      if(!isUnsignedField(info, id) || !isSignedField(info, id+1) || !alph[id+2]) return ERROR;
+    }
+    return CREATE;
   }
 
-  uint32_t curr_dist = 0;
-  uint32_t curr_sum = 0;
-  uint32_t len = strlen(s) + 1;
-
-  while(curr_sum < len){
-    if(size + 1 >= buffer_size){
-      buffer_size *= 2;
-
-      char const **old_args = args;
-      args = (char const**)realloc(args, buffer_size * sizeof(char const*));
-      if(args == NULL){
-        free(old_args);
-        free(num);
-        free(alph);
-        return false;
-      }
+  if(!alph[0]) return ERROR;
+  int32_t code = commandCode(info->args[0], firstLength);
 
-      bool *old_num = num;
-      num = (bool*)realloc(num, buffer_size * sizeof(bool));
-      if(num == NULL){
-        free(args);
-        free(old_num);
-        free(alph);
-        return false;
-      }
+  if(code == ADD){
+    if(size != 5 || !alph[1] || !alph[2] || !isUnsignedField(info, 3) || !isSignedField(info, 4)) return ERROR;
+    return ADD;
+  }
 
-      bool *old_alph = alph;
-      alph = (bool*)realloc(alph, buffer_size * sizeof(bool));
-      if(alph == NULL){
-        free(args);
-        free(num);
-        free(old_alph);
-        return false;
-      }
-    }
+  if(code == REPAIR){
+    if(size != 4 || !alph[1] || !alph[2] || !isSignedField(info, 3)) return ERROR;
+    return REPAIR;
+  }
 
-    args[size] = extract(s + curr_sum, &curr_dist, &num[size], &alph[size]);
-    size++;
-    curr_sum += curr_dist + 1;
+  if(code == DESCR){
+    if(size != 2 || !isUnsignedField(info, 1)) return ERROR;
+    return DESCR;
   }
 
-  int32_t icheck = 0;
-  uint32_t ucheck = 0;
+  if(code == DIST){
+    if(size != 3 || !alph[1] || !alph[2]) return ERROR;
+    return DIST;
+  }
 
-  if(num[0]){
-    if(size < 3 || !toUnsigned(args[0], &ucheck) || !alph[1] || (size-2)%3 != 0){
-      free_args(num, alph);
-      writeInfo(ERROR, args, size, dest, s);
-      return true;
-    }
+  if(code == BATCH){
+    if(size < 4 || size%2 != 0 || !alph[1]) return ERROR;
 
-    int32_t id = 2;
-    int32_t routes_count = (size-2)/3;
-
-    for(int32_t i=0; i<routes_count; i++){
-      for(int32_t j=1; j<=3; j++){
-
-        if(j == 1){
-          if(!num[id] || !toUnsigned(args[id], &ucheck)){
-            free_args(num, alph);
-            writeInfo(ERROR, args, size, dest, s);
-            return true;
-          }
-        }
-
-        if(j == 2){
-          if(!num[id] || !toSigned(args[id], &icheck)){
-            free_args(num, alph);
-            writeInfo(ERROR, args, size, dest, s);
-            return true;
-          }
-        }
-
-        if(j == 3){
-          if(!alph[id]){
-            free_args(num, alph);
-            writeInfo(ERROR, args, size, dest, s);
-            return true;
-          }
-        }
-
-        id++;
-      }
+    for(int32_t id = 2; id < size; id += 2){
+      if(!isUnsignedField(info, id) || !alph[id+1]) return ERROR;
     }
-
-    writeInfo(CREATE, args, size, dest, s);
-    free_args(num, alph);
-    return true;
+    return BATCH;
   }
 
-  else if(alph[0]){
-    bool add_cmp = !strcmp(args[0], _add);
-    bool repair_cmp = !strcmp(args[0], _repair);
-    bool descr_cmp = !strcmp(args[0], _descr);
+  return ERROR;
+}
 
-    if(add_cmp || repair_cmp){
-      if(size < 4 || !alph[1] || !alph[2]){
-        free_args(num, alph);
-        writeInfo(ERROR, args, size, dest, s);
-        return true;
-      }
+bool whatToDo(char *s, Info *dest){
+  dest->size = 0;
+  dest->beg = s;
 
-      if(repair_cmp){
-        if(size != 4 || !num[3] || !toSigned(args[3], &icheck)){
-          free_args(num, alph);
-          writeInfo(ERROR, args, size, dest, s);
-          return true;
-        }
+  if(s == NULL){
+    dest->code = ERROR;
+    return true;
+  }
 
-        writeInfo(REPAIR, args, size, dest, s);
-        free_args(num, alph);
-        return true;
-      }
+  if(*s == '#' || *s == 0){
+    dest->code = IGNORE;
+    return true;
+  }
 
-      if(add_cmp){
-        if(size != 5 || !num[3] || !toUnsigned(args[3], &ucheck)){
-          free_args(num, alph);
-          writeInfo(ERROR, args, size, dest, s);
-          return true;
-        }
-
-        if(!num[4] || !toSigned(args[4], &icheck)){
-          free_args(num, alph);
-          writeInfo(ERROR, args, size, dest, s);
-          return true;
-        }
-
-        writeInfo(ADD, args, size, dest, s);
-        free_args(num, alph);
-        return true;
-      }
-    }
+  uint32_t len = strlen(s);
+  uint32_t curr_sum = 0;
+  uint32_t firstLength = 0;
 
-    if(descr_cmp){
-      if(size != 2 || !num[1] || !toUnsigned(args[1], &ucheck)){
-        free_args(num, alph);
-        writeInfo(ERROR, args, size, dest, s);
-        return true;
-      }
+  while(curr_sum <= len){
+    if(dest->size == (int32_t)dest->capacity && !growInfo(dest)) return false;
 
-      writeInfo(DESCR, args, size, dest, s);
-      free_args(num, alph);
-      return true;
-    }
+    uint32_t curr_dist = extract(s + curr_sum, len - curr_sum, dest, dest->size);
+    if(dest->size == 0) firstLength = curr_dist;
+    dest->size++;
+    curr_sum += curr_dist + 1;
   }
 
-  free_args(num, alph);
-  writeInfo(ERROR, args, size, dest, s);
+  dest->code = classify(dest, firstLength);
   return true;
 }
@@ -14,47 +14,111 @@
 #include <inttypes.h>
 
 /**
- * Struktura przechowująca zparsowane dane z wejścia
+ * Struktura przechowująca zparsowane dane z wejścia. Tablice pól są
+ * używane ponownie dla kolejnych linii i rosną tylko wtedy, gdy linia ma
+ * więcej pól niż którakolwiek wcześniejsza.
  */
 typedef struct Info {
   /*@{*/
-  int32_t code; /**< kod, w zależności od danych ERROR, IGNORE, ADD, REPAIR, DESCR lub CREATE */
-  int32_t size; /**< rozmiar tablicy stringów z wejscia */
-  char const **args; /**< tablica stringów z wejścia */
-  char *beg; /**< wskaźnik na zaalokowaną na daną linię przez readLine pamięć */
+  int32_t code; /**< kod, w zależności od danych ERROR, IGNORE, ADD, REPAIR, DESCR, CREATE, DIST lub BATCH */
+  int32_t size; /**< liczba pól linii */
+  uint32_t capacity; /**< rozmiar tablic args, values, num i alph */
+  char const **args; /**< pola linii (fragmenty linii z wejścia) */
+  int64_t *values; /**< wartości pól, które są liczbami */
+  bool *num; /**< informacje, czy pola są liczbami (cyfry, na pierwszej pozycji dopuszczany '-') */
+  bool *alph; /**< informacje, czy pola nie zawierają znaków sterujących */
+  char *beg; /**< wskaźnik na początek linii w buforze wejścia */
   /*@}*/
 } Info;
 
+/**
+ * Wejście czytane blokami. Linie są udostępniane bez kopiowania, jako
+ * fragmenty bufora zakończone zerem; bufor rośnie tylko wtedy, gdy pojedyncza
+ * linia się w nim nie mieści.
+ */
+typedef struct Input {
+  /*@{*/
+  FILE *file; /**< czytany plik */
+  char *buffer; /**< bufor wczytanych danych */
+  size_t capacity; /**< rozmiar bufora */
+  size_t begin; /**< pozycja początku nieprzeczytanej części bufora */
+  size_t end; /**< pozycja końca wczytanych danych */
+  bool eof; /**< informacja, czy plik został przeczytany do końca */
+  /*@}*/
+} Input;
+
 /** @brief Tworzy nową strukturę "Info"
  * @return Zwraca wskaźnik na powstałą strukturę.
  */
 Info *createInfo();
 
-/** @brief Czyta linię ze standardowego wejścia i zapisuje ją w dest.
+/** @brief Usuwa strukturę "Info" razem z jej tablicami pól.
+ * @param[in] info      - wskaźnik na strukturę lub NULL
+ */
+void deleteInfo(Info *info);
+
+/** @brief Inicjalizuje wejście czytające z podanego pliku.
+ * Nie alokuje pamięci. Dane są pobierane bezpośrednio z deskryptora pliku,
+ * z pominięciem buforów stdio, więc z pliku nie należy czytać w inny sposób.
+ * @param[out] input      - wskaźnik na wejście
+ * @param[in] file      - czytany plik
+ */
+void inputInit(Input *input, FILE *file);
+
+/** @brief Zwalnia bufor wejścia.
+ * @param[in, out] input      - wskaźnik na wejście
+ */
+void inputFree(Input *input);
+
+/** @brief Czyta kolejną linię wejścia i zapisuje ją w dest.
+ * Linia pozostaje w buforze wejścia (bez znaku nowej linii, zakończona zerem)
+ * i jest ważna do następnego wywołania; nie należy jej zwalniać. Linia
+ * zawierająca znaki sterujące, o ile nie jest komentarzem, jest zastępowana
+ * przez NULL.
+ * @param[in, out] input      - wskaźnik na wejście
  * @param[out] dest      - wskaźnik na stringa, w którym zostanie zapisana wczytana linia
+ * @param[out] last      - tu zostanie zapisane, czy linia była zakończona końcem pliku
+ * zamiast znaku nowej linii
+ * @param[out] longRoute      - tu zostanie zapisane, czy linia jest bardzo długą linią
+ * zaczynającą się od cyfry; wtedy dest jest równe NULL, a linię należy przeczytać
+ * za pomocą readField
+ * @return Zwraca true w przypadku sukcesu, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool readLine(Input *input, char **dest, bool *last, bool *longRoute);
+
+/** @brief Czyta kolejne pole bieżącej linii wejścia.
+ * Pole jest wydzielane w buforze wejścia tak jak przez whatToDo i zapisywane
+ * jako jedyne pole w dest; jest ważne do następnego odczytu. Bufor mieści
+ * jednocześnie tylko jedno pole, więc linia może być dowolnie długa. Pole
+ * zawierające znak sterujący nie jest ani liczbą, ani poprawną nazwą.
+ * @param[in, out] input      - wskaźnik na wejście
+ * @param[out] dest      - wskaźnik na strukturę Info, w której zostanie zapisane pole
+ * @param[out] lineEnd      - tu zostanie zapisane, czy było to ostatnie pole linii
+ * @param[out] last      - tu zostanie zapisane, czy linia była zakończona końcem pliku
+ * zamiast znaku nowej linii
  * @return Zwraca true w przypadku sukcesu, lub false jeśli nie udało się zaalokować pamięci.
  */
-bool readLine(char **dest);
+bool readField(Input *input, Info *dest, bool *lineEnd, bool *last);
 
-/** @brief Zapisuje w dest reprezentację danego stringa jako int.
- * Założenie: string składa się z cyfr (na pierwszej pozycji dopuszczany '-')
- * @param[in] s      - string
- * @param[out] dest      - wskaźnik na inta, w którym zostanie zapisany rezultat
- * @return zwraca true w przypadku sukcesu, lub false gdy string nie był poprawny:
- * jego wartość była poza zakresem, posiadał zera wiodące.
+/** @brief Sprawdza, czy pole jest poprawną liczbą typu unsigned.
+ * @param[in] info      - wskaźnik na strukturę z polami linii
+ * @param[in] k      - numer pola
+ * @return Zwraca true jeśli pole jest liczbą bez znaku mieszczącą się w zakresie;
+ * jej wartość jest wtedy w info->values[k].
  */
-bool toSigned(char const *s, int32_t *dest);
+bool isUnsignedField(Info *info, int32_t k);
 
-/** @brief Zapisuje w dest reprezentację danego stringa jako unsigned.
- * Założenie: string składa się z cyfr
- * @param[in] s      - string
- * @param[out] dest      - wskaźnik na unsigned, w którym zostanie zapisany rezultat
- * @return zwraca true w przypadku sukcesu, lub false gdy string nie był poprawny:
- * jego wartość była poza zakresem, posiadał zera wiodące.
+/** @brief Sprawdza, czy pole jest poprawną liczbą typu int.
+ * @param[in] info      - wskaźnik na strukturę z polami linii
+ * @param[in] k      - numer pola
+ * @return Zwraca true jeśli pole jest liczbą mieszczącą się w zakresie;
+ * jej wartość jest wtedy w info->values[k].
  */
-bool toUnsigned(char const *s, uint32_t *dest);
+bool isSignedField(Info *info, int32_t k);
 
-/** @brief Na podstawie linii z wejścia, zapisuje zparsowane dane we wskazanej strukturze "Info"
+/** @brief Na podstawie linii z wejścia, zapisuje zparsowane dane we wskazanej strukturze "Info".
+ * Pola linii są wydzielane w miejscu (średniki są zastępowane zerami), a pola
+ * liczbowe są od razu zamieniane na wartości.
  * @param[in] s      - linia z wejścia
  * @param[out] dest      - wskaźnik na strukturę Info, na której zostaną zapisane dane
  * @return Zwraca true w przypadku sukcesu, lub false jeśli nie udało się zaalokować pamięci.
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "pool.h"
+
+static const size_t ALIGNMENT = _Alignof(max_align_t);
+static const uint32_t FIRST_SLAB = 64;
+static const uint32_t MAX_SLAB = 4096;
+static const size_t ARENA_BLOCK = 65536;
+
+static size_t alignUp(size_t size){
+  return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+//POOL
+
+void poolInit(Pool *pool, size_t objSize){
+  if(objSize < sizeof(void*)) objSize = sizeof(void*);
+  pool->objSize = (objSize + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+  pool->perSlab = FIRST_SLAB;
+  pool->freeList = NULL;
+  pool->slabs = NULL;
+  pool->bump = NULL;
+  pool->bumpEnd = NULL;
+}
+
+void *poolAlloc(Pool *pool){
+  if(pool->freeList != NULL){
+    void *ptr = pool->freeList;
+    pool->freeList = *(void**)ptr;
+    return ptr;
+  }
+
+  if(pool->bump == pool->bumpEnd){
+    size_t header = alignUp(sizeof(PoolSlab));
+    PoolSlab *slab = (PoolSlab*)malloc(header + pool->perSlab * pool->objSize);
+    if(slab == NULL) return NULL;
+
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->bump = (char*)slab + header;
+    pool->bumpEnd = pool->bump + pool->perSlab * pool->objSize;
+    if(pool->perSlab < MAX_SLAB) pool->perSlab *= 2;
+  }
+
+  void *ptr = pool->bump;
+  pool->bump += pool->objSize;
+  return ptr;
+}
+
+void poolFree(Pool *pool, void *ptr){
+  if(ptr == NULL) return;
+  *(void**)ptr = pool->freeList;
+  pool->freeList = ptr;
+}
+
+void poolDestroy(Pool *pool){
+  while(pool->slabs != NULL){
+    PoolSlab *next = pool->slabs->next;
+    free(pool->slabs);
+    pool->slabs = next;
+  }
+  pool->freeList = NULL;
+  pool->bump = NULL;
+  pool->bumpEnd = NULL;
+  pool->perSlab = FIRST_SLAB;
+}
+
+//ARENA
+
+void arenaInit(Arena *arena){
+  arena->first = NULL;
+  arena->current = NULL;
+  arena->used = 0;
+}
+
+static ArenaBlock *newBlock(size_t size){
+  if(size < ARENA_BLOCK) size = ARENA_BLOCK;
+  ArenaBlock *block = (ArenaBlock*)malloc(alignUp(sizeof(ArenaBlock)) + size);
+  if(block == NULL) return NULL;
+  block->next = NULL;
+  block->size = size;
+  return block;
+}
+
+// Wydziela size bajtów z bieżącego bloku, od pozycji used zaokrąglonej w górę
+// do wyrównania, jeśli aligned; nowe bloki zaczynają się od wyrównanego adresu.
+static void *arenaTake(Arena *arena, size_t size, bool aligned){
+  if(arena->current == NULL){
+    if(arena->first == NULL){
+      arena->first = newBlock(size);
+      if(arena->first == NULL) return NULL;
+    }
+    arena->current = arena->first;
+    arena->used = 0;
+  }
+
+  size_t start = aligned ? alignUp(arena->used) : arena->used;
+  while(start + size > arena->current->size){
+    ArenaBlock *next = arena->current->next;
+    if(next == NULL || next->size < size){
+      // Za małe bloki pomijamy, wstawiając nowy przed nimi.
+      ArenaBlock *block = newBlock(size);
+      if(block == NULL) return NULL;
+      block->next = next;
+      arena->current->next = block;
+      next = block;
+    }
+    arena->current = next;
+    arena->used = 0;
+    start = 0;
+  }
+
+  void *ptr = (char*)(arena->current) + alignUp(sizeof(ArenaBlock)) + start;
+  arena->used = start + size;
+  return ptr;
+}
+
+void *arenaAlloc(Arena *arena, size_t size){
+  return arenaTake(arena, alignUp(size), true);
+}
+
+void *arenaAllocUnaligned(Arena *arena, size_t size){
+  return arenaTake(arena, size, false);
+}
+
+void arenaDestroy(Arena *arena){
+  while(arena->first != NULL){
+    ArenaBlock *next = arena->first->next;
+    free(arena->first);
+    arena->first = next;
+  }
+  arena->current = NULL;
+  arena->used = 0;
+}
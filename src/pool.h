@@ -0,0 +1,110 @@
+/** @file
+ * Alokatory pamięci: pule obiektów stałego rozmiaru oraz arena.
+ *
+ * @author Jakub Organa
+ * @date 17.10.2026
+ */
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdbool.h>
+
+/**
+ * Nagłówek płyty (slab) puli; za nim leżą obiekty.
+ */
+typedef struct PoolSlab {
+  /*@{*/
+  struct PoolSlab *next; /**< następna płyta */
+  /*@}*/
+} PoolSlab;
+
+/**
+ * Pula obiektów jednego rozmiaru. Obiekty są wydzielane kolejno z płyt,
+ * a zwolnione trafiają na listę wolnych i są używane ponownie.
+ */
+typedef struct Pool {
+  /*@{*/
+  size_t objSize; /**< rozmiar obiektu (zaokrąglony do wyrównania) */
+  uint32_t perSlab; /**< liczba obiektów w następnej płycie */
+  void *freeList; /**< lista zwolnionych obiektów */
+  PoolSlab *slabs; /**< lista płyt */
+  char *bump; /**< pierwszy niewydzielony obiekt bieżącej płyty */
+  char *bumpEnd; /**< koniec bieżącej płyty */
+  /*@}*/
+} Pool;
+
+/**
+ * Blok areny; za nagłówkiem leżą dane.
+ */
+typedef struct ArenaBlock {
+  /*@{*/
+  struct ArenaBlock *next; /**< następny blok */
+  size_t size; /**< rozmiar danych bloku */
+  /*@}*/
+} ArenaBlock;
+
+/**
+ * Arena: pamięć wydzielana kolejno z bloków i zwalniana tylko w całości.
+ */
+typedef struct Arena {
+  /*@{*/
+  ArenaBlock *first; /**< pierwszy blok */
+  ArenaBlock *current; /**< blok, z którego aktualnie wydzielamy pamięć */
+  size_t used; /**< liczba zajętych bajtów bieżącego bloku */
+  /*@}*/
+} Arena;
+
+/** @brief Inicjalizuje pustą pulę.
+ * @param[out] pool      - wskaźnik na pulę
+ * @param[in] objSize      - rozmiar obiektów
+ */
+void poolInit(Pool *pool, size_t objSize);
+
+/** @brief Przydziela obiekt z puli.
+ * @param[in, out] pool      - wskaźnik na pulę
+ * @return Zwraca wskaźnik na obiekt, lub NULL jeśli nie udało się zaalokować pamięci.
+ */
+void *poolAlloc(Pool *pool);
+
+/** @brief Oddaje obiekt do puli.
+ * @param[in, out] pool      - wskaźnik na pulę
+ * @param[in] ptr      - wskaźnik na obiekt (może być NULL)
+ */
+void poolFree(Pool *pool, void *ptr);
+
+/** @brief Zwalnia całą pamięć puli, a z nią wszystkie jej obiekty.
+ * @param[in, out] pool      - wskaźnik na pulę
+ */
+void poolDestroy(Pool *pool);
+
+/** @brief Inicjalizuje pustą arenę.
+ * @param[out] arena      - wskaźnik na arenę
+ */
+void arenaInit(Arena *arena);
+
+/** @brief Przydziela pamięć z areny.
+ * @param[in, out] arena      - wskaźnik na arenę
+ * @param[in] size      - liczba bajtów
+ * @return Zwraca wskaźnik na pamięć, lub NULL jeśli nie udało się zaalokować pamięci.
+ */
+void *arenaAlloc(Arena *arena, size_t size);
+
+/** @brief Przydziela pamięć z areny bez wyrównania.
+ * Kolejne przydziały leżą jeden za drugim, bez wypełnienia, więc nadaje się
+ * to do przechowywania napisów.
+ * @param[in, out] arena      - wskaźnik na arenę
+ * @param[in] size      - liczba bajtów
+ * @return Zwraca wskaźnik na pamięć, lub NULL jeśli nie udało się zaalokować pamięci.
+ */
+void *arenaAllocUnaligned(Arena *arena, size_t size);
+
+/** @brief Zwalnia całą pamięć areny.
+ * @param[in, out] arena      - wskaźnik na arenę
+ */
+void arenaDestroy(Arena *arena);
+
+#endif /* __POOL_H__ */
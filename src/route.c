@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "types.h"
+#include "hash.h"
+#include "route.h"
+
+static const uint32_t MIN_SLACK = 4;
+static const uint32_t INITIAL_SLOTS = 16;
+
+void routeInit(Route *route, uint32_t id){
+  route->id = id;
+  route->roads = NULL;
+  route->start = 0;
+  route->count = 0;
+  route->capacity = 0;
+  cityIndexInit(&(route->positions));
+}
+
+void routeFree(Route *route){
+  free(route->roads);
+  cityIndexFree(&(route->positions));
+  routeInit(route, route->id);
+}
+
+// Zapisuje w indeksie pozycję i-tego miasta drogi.
+static void indexCity(Route *route, uint32_t i){
+  City *cityPtr;
+  if(i < route->count) cityPtr = route->roads[route->start + i]->reversed->dest;
+  else cityPtr = route->roads[route->start + i - 1]->dest;
+  cityIndexPut(&(route->positions), cityPtr->id, route->start + i);
+}
+
+bool routeReserve(Route *route, uint32_t count){
+  if(!cityIndexReserve(&(route->positions), count + 1)) return false;
+  if(route->start >= count && route->capacity - route->start - route->count >= count) return true;
+
+  // Wolne miejsce po każdej stronie rośnie razem z drogą, więc przenoszenie
+  // bufora ma zamortyzowany koszt stały na dokładany odcinek.
+  uint32_t slack = route->count / 2 + MIN_SLACK;
+  if(slack < count) slack = count;
+  uint32_t capacity = route->count + 2 * slack;
+
+  Neigh **roads = (Neigh**)malloc(capacity * sizeof(Neigh*));
+  if(roads == NULL) return false;
+  if(route->count > 0){
+    memcpy(roads + slack, route->roads + route->start, route->count * sizeof(Neigh*));
+  }
+
+  free(route->roads);
+  route->roads = roads;
+  route->start = slack;
+  route->capacity = capacity;
+  for(uint32_t i = 0; route->count > 0 && i <= route->count; i++) indexCity(route, i);
+  return true;
+}
+
+Neigh *routeRoad(Route *route, uint32_t i){
+  return route->roads[route->start + i];
+}
+
+City *routeFirstCity(Route *route){
+  return route->roads[route->start]->reversed->dest;
+}
+
+City *routeLastCity(Route *route){
+  return route->roads[route->start + route->count - 1]->dest;
+}
+
+bool routeFind(Route *route, City *cityPtr, uint32_t *i){
+  uint32_t position;
+  if(!cityIndexFind(&(route->positions), cityPtr->id, &position)) return false;
+  *i = position - route->start;
+  return true;
+}
+
+void routeAppend(Route *route, Neigh **roads, uint32_t count){
+  if(count == 0) return;
+  uint32_t first = route->count == 0 ? 0 : route->count + 1;
+
+  memcpy(route->roads + route->start + route->count, roads, count * sizeof(Neigh*));
+  route->count += count;
+  for(uint32_t i = first; i <= route->count; i++) indexCity(route, i);
+}
+
+void routePrepend(Route *route, Neigh **roads, uint32_t count){
+  route->start -= count;
+  memcpy(route->roads + route->start, roads, count * sizeof(Neigh*));
+  route->count += count;
+  for(uint32_t i = 0; i < count; i++) indexCity(route, i);
+}
+
+void routeSplice(Route *route, uint32_t i, Neigh **roads, uint32_t count){
+  uint32_t extra = count - 1;
+  if(extra == 0){
+    route->roads[route->start + i] = roads[0];
+    return;
+  }
+
+  uint32_t before = i;
+  uint32_t after = route->count - i - 1;
+  if(before <= after){
+    memmove(route->roads + route->start - extra, route->roads + route->start, before * sizeof(Neigh*));
+    route->start -= extra;
+    route->count += extra;
+    memcpy(route->roads + route->start + i, roads, count * sizeof(Neigh*));
+    for(uint32_t k = 0; k <= i + extra; k++) indexCity(route, k);
+  } else {
+    Neigh **tail = route->roads + route->start + i + 1;
+    memmove(tail + extra, tail, after * sizeof(Neigh*));
+    route->count += extra;
+    memcpy(route->roads + route->start + i, roads, count * sizeof(Neigh*));
+    for(uint32_t k = i + 1; k <= route->count; k++) indexCity(route, k);
+  }
+}
+
+//ROUTE TABLE
+
+void routeTableInit(RouteTable *table){
+  table->routes = NULL;
+  table->count = 0;
+  table->capacity = 0;
+  table->slots = NULL;
+  table->slotsCount = 0;
+}
+
+static uint32_t findRouteSlot(RouteTable *table, uint32_t *slots, uint32_t mask, uint32_t id){
+  uint32_t i = hashKey(id) & mask;
+  while(slots[i] != 0 && table->routes[slots[i] - 1]->id != id) i = (i + 1) & mask;
+  return i;
+}
+
+Route *routeTableFind(RouteTable *table, uint32_t id){
+  if(table->count == 0) return NULL;
+  uint32_t slot = table->slots[findRouteSlot(table, table->slots, table->slotsCount - 1, id)];
+  if(slot == 0) return NULL;
+  return table->routes[slot - 1];
+}
+
+bool routeTableReserve(RouteTable *table, uint32_t count){
+  if(table->capacity - table->count < count){
+    uint32_t newCapacity = table->capacity == 0 ? INITIAL_SLOTS : 2 * table->capacity;
+    while(newCapacity - table->count < count) newCapacity *= 2;
+    Route **newRoutes = (Route**)realloc(table->routes, newCapacity * sizeof(Route*));
+    if(newRoutes == NULL) return false;
+    table->routes = newRoutes;
+    table->capacity = newCapacity;
+  }
+
+  // Współczynnik zapełnienia nie przekracza 1/2.
+  if(2 * (table->count + count) <= table->slotsCount) return true;
+
+  uint32_t newCount = table->slotsCount == 0 ? INITIAL_SLOTS : 2 * table->slotsCount;
+  while(newCount < 2 * (table->count + count)) newCount *= 2;
+  uint32_t *newSlots = (uint32_t*)calloc(newCount, sizeof(uint32_t));
+  if(newSlots == NULL) return false;
+  for(uint32_t k = 0; k < table->count; k++){
+    newSlots[findRouteSlot(table, newSlots, newCount - 1, table->routes[k]->id)] = k + 1;
+  }
+
+  free(table->slots);
+  table->slots = newSlots;
+  table->slotsCount = newCount;
+  return true;
+}
+
+void routeTableAdd(RouteTable *table, Route *route){
+  table->routes[table->count] = route;
+  table->count++;
+  table->slots[findRouteSlot(table, table->slots, table->slotsCount - 1, route->id)] = table->count;
+}
+
+void routeTableFree(RouteTable *table){
+  for(uint32_t k = 0; k < table->count; k++){
+    routeFree(table->routes[k]);
+    free(table->routes[k]);
+  }
+  free(table->routes);
+  free(table->slots);
+  routeTableInit(table);
+}
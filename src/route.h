@@ -0,0 +1,161 @@
+/** @file
+ * Droga krajowa przechowywana jako ciągła tablica odcinków z indeksem pozycji
+ * miast.
+ *
+ * @author Jakub Organa
+ * @date 17.10.2026
+ */
+
+#ifndef __ROUTE_H__
+#define __ROUTE_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include "types.h"
+#include "hash.h"
+
+/**
+ * Droga krajowa. Odcinki, skierowane od pierwszego miasta do ostatniego,
+ * zajmują w buforze pozycje od start do start + count - 1, z wolnym miejscem
+ * po obu stronach, więc dokładanie odcinków na początku i na końcu nie
+ * przesuwa pozostałych. Miasto, z którego wychodzi odcinek na pozycji p, ma
+ * w indeksie pozycję p, a ostatnie miasto – pozycję start + count.
+ */
+typedef struct Route {
+  /*@{*/
+  uint32_t id; /**< numer drogi krajowej */
+  Neigh **roads; /**< bufor odcinków */
+  uint32_t start; /**< pozycja pierwszego odcinka w buforze */
+  uint32_t count; /**< liczba odcinków */
+  uint32_t capacity; /**< rozmiar bufora */
+  CityIndex positions; /**< pozycje miast drogi w buforze */
+  /*@}*/
+} Route;
+
+/**
+ * Tablica dróg krajowych. Istniejące drogi są trzymane w zwartej tablicy, a
+ * wyszukiwanie po numerze odbywa się przez tablicę mieszającą z adresowaniem
+ * otwartym, więc zajmowana pamięć zależy od liczby dróg, a nie od zakresu
+ * numerów.
+ */
+typedef struct RouteTable {
+  /*@{*/
+  Route **routes; /**< istniejące drogi krajowe w kolejności dodawania */
+  uint32_t count; /**< liczba dróg */
+  uint32_t capacity; /**< rozmiar tablicy routes */
+  uint32_t *slots; /**< kubełki tablicy mieszającej (pozycja w routes + 1, lub 0 gdy pusty) */
+  uint32_t slotsCount; /**< liczba kubełków (potęga dwójki lub 0) */
+  /*@}*/
+} RouteTable;
+
+/** @brief Inicjalizuje pustą drogę krajową.
+ * Nie alokuje pamięci.
+ * @param[out] route      - wskaźnik na drogę
+ * @param[in] id      - numer drogi krajowej
+ */
+void routeInit(Route *route, uint32_t id);
+
+/** @brief Zwalnia pamięć drogi krajowej, pozostawiając ją pustą.
+ * @param[in, out] route      - wskaźnik na drogę
+ */
+void routeFree(Route *route);
+
+/** @brief Zapewnia miejsce na podaną liczbę odcinków po każdej stronie drogi.
+ * Po powodzeniu wydłużenie drogi lub wstawienie objazdu o co najwyżej tylu
+ * nowych odcinkach nie alokuje już pamięci.
+ * @param[in, out] route      - wskaźnik na drogę
+ * @param[in] count      - liczba odcinków
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool routeReserve(Route *route, uint32_t count);
+
+/** @brief Zwraca odcinek drogi krajowej.
+ * @param[in] route      - wskaźnik na drogę
+ * @param[in] i      - numer odcinka (od 0)
+ * @return Zwraca wskaźnik na odcinek skierowany zgodnie z drogą.
+ */
+Neigh *routeRoad(Route *route, uint32_t i);
+
+/** @brief Zwraca pierwsze miasto niepustej drogi krajowej.
+ * @param[in] route      - wskaźnik na drogę
+ * @return Zwraca wskaźnik na miasto.
+ */
+City *routeFirstCity(Route *route);
+
+/** @brief Zwraca ostatnie miasto niepustej drogi krajowej.
+ * @param[in] route      - wskaźnik na drogę
+ * @return Zwraca wskaźnik na miasto.
+ */
+City *routeLastCity(Route *route);
+
+/** @brief Wyszukuje miasto na drodze krajowej.
+ * @param[in] route      - wskaźnik na drogę
+ * @param[in] cityPtr      - wskaźnik na miasto
+ * @param[out] i      - tu zostanie zapisany numer odcinka wychodzącego z miasta
+ * (dla ostatniego miasta: liczba odcinków)
+ * @return Zwraca true jeśli miasto leży na drodze, lub false w przeciwnym przypadku.
+ */
+bool routeFind(Route *route, City *cityPtr, uint32_t *i);
+
+/** @brief Dokłada odcinki na końcu drogi krajowej (lub tworzy z nich drogę).
+ * Założenie: miejsce zostało zapewnione przez routeReserve.
+ * @param[in, out] route      - wskaźnik na drogę
+ * @param[in] roads      - kolejne odcinki, zaczynające się w ostatnim mieście drogi
+ * @param[in] count      - liczba odcinków
+ */
+void routeAppend(Route *route, Neigh **roads, uint32_t count);
+
+/** @brief Dokłada odcinki na początku drogi krajowej.
+ * Założenie: miejsce zostało zapewnione przez routeReserve.
+ * @param[in, out] route      - wskaźnik na drogę
+ * @param[in] roads      - kolejne odcinki, kończące się w pierwszym mieście drogi
+ * @param[in] count      - liczba odcinków
+ */
+void routePrepend(Route *route, Neigh **roads, uint32_t count);
+
+/** @brief Zastępuje odcinek drogi krajowej objazdem.
+ * Przesuwana jest krótsza z części drogi po obu stronach odcinka.
+ * Założenie: miejsce zostało zapewnione przez routeReserve.
+ * @param[in, out] route      - wskaźnik na drogę
+ * @param[in] i      - numer zastępowanego odcinka
+ * @param[in] roads      - kolejne odcinki objazdu, skierowane zgodnie z drogą
+ * @param[in] count      - liczba odcinków objazdu (co najmniej 1)
+ */
+void routeSplice(Route *route, uint32_t i, Neigh **roads, uint32_t count);
+
+/** @brief Inicjalizuje pustą tablicę dróg krajowych.
+ * Nie alokuje pamięci.
+ * @param[out] table      - wskaźnik na tablicę
+ */
+void routeTableInit(RouteTable *table);
+
+/** @brief Wyszukuje drogę krajową o podanym numerze.
+ * @param[in] table      - wskaźnik na tablicę
+ * @param[in] id      - numer drogi krajowej
+ * @return Zwraca wskaźnik na drogę, lub NULL jeśli taka droga nie istnieje.
+ */
+Route *routeTableFind(RouteTable *table, uint32_t id);
+
+/** @brief Zapewnia w tablicy miejsce na podaną liczbę kolejnych dróg krajowych.
+ * @param[in, out] table      - wskaźnik na tablicę
+ * @param[in] count      - liczba dróg
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool routeTableReserve(RouteTable *table, uint32_t count);
+
+/** @brief Dodaje drogę krajową do tablicy, która przejmuje ją na własność.
+ * Założenie: miejsce zostało zapewnione przez routeTableReserve, a w tablicy
+ * nie ma drogi o tym samym numerze.
+ * @param[in, out] table      - wskaźnik na tablicę
+ * @param[in] route      - wskaźnik na zaalokowaną drogę
+ */
+void routeTableAdd(RouteTable *table, Route *route);
+
+/** @brief Zwalnia pamięć tablicy razem ze wszystkimi drogami krajowymi.
+ * @param[in, out] table      - wskaźnik na tablicę
+ */
+void routeTableFree(RouteTable *table);
+
+#endif /* __ROUTE_H__ */
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "scan.h"
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <immintrin.h>
+#define SCAN_SIMD
+#endif
+
+static bool isControl(char c){
+  return c <= 31 && c >= 0;
+}
+
+static bool isDigit(char c){
+  return c >= '0' && c <= '9';
+}
+
+static size_t controlTail(const char *s, size_t i, size_t length){
+  while(i < length && !isControl(s[i])) i++;
+  return i;
+}
+
+static size_t fieldTail(const char *s, size_t i, size_t length, bool found, size_t *nonDigit){
+  for(; i < length; i++){
+    if(!found && !isDigit(s[i])){
+      *nonDigit = i;
+      found = true;
+    }
+    if(s[i] == ';' || isControl(s[i])) return i;
+  }
+  if(!found) *nonDigit = length;
+  return length;
+}
+
+#ifdef SCAN_SIMD
+
+// Znak sterujący to bajt, którego trzy najstarsze bity są zerami; bajty
+// powyżej 127 (ujemne znaki) do nich nie należą.
+static size_t controlSse2(const char *s, size_t length){
+  const __m128i high = _mm_set1_epi8((char)0xE0);
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for(; i + 16 <= length; i += 16){
+    __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+    uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, high), zero));
+    if(mask != 0) return i + __builtin_ctz(mask);
+  }
+  return controlTail(s, i, length);
+}
+
+// Cyfra to bajt b, dla którego b - '0' (bez znaku) nie przekracza 9.
+static size_t fieldSse2(const char *s, size_t length, size_t *nonDigit){
+  const __m128i high = _mm_set1_epi8((char)0xE0);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i separator = _mm_set1_epi8(';');
+  const __m128i digitBase = _mm_set1_epi8('0');
+  const __m128i nine = _mm_set1_epi8(9);
+  bool found = false;
+  size_t i = 0;
+  for(; i + 16 <= length; i += 16){
+    __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+    __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(v, separator), _mm_cmpeq_epi8(_mm_and_si128(v, high), zero));
+    __m128i offset = _mm_sub_epi8(v, digitBase);
+    __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(offset, nine), offset);
+
+    uint32_t other = ~(uint32_t)_mm_movemask_epi8(digit) & 0xFFFF;
+    if(!found && other != 0){
+      *nonDigit = i + __builtin_ctz(other);
+      found = true;
+    }
+    uint32_t mask = _mm_movemask_epi8(stop);
+    if(mask != 0) return i + __builtin_ctz(mask);
+  }
+  return fieldTail(s, i, length, found, nonDigit);
+}
+
+__attribute__((target("avx2")))
+static size_t controlAvx2(const char *s, size_t length){
+  const __m256i high = _mm256_set1_epi8((char)0xE0);
+  const __m256i zero = _mm256_setzero_si256();
+  size_t i = 0;
+  for(; i + 32 <= length; i += 32){
+    __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+    uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(v, high), zero));
+    if(mask != 0) return i + __builtin_ctz(mask);
+  }
+  return i + controlSse2(s + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static size_t fieldAvx2(const char *s, size_t length, size_t *nonDigit){
+  const __m256i high = _mm256_set1_epi8((char)0xE0);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i separator = _mm256_set1_epi8(';');
+  const __m256i digitBase = _mm256_set1_epi8('0');
+  const __m256i nine = _mm256_set1_epi8(9);
+  bool found = false;
+  size_t i = 0;
+  for(; i + 32 <= length; i += 32){
+    __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+    __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(v, separator), _mm256_cmpeq_epi8(_mm256_and_si256(v, high), zero));
+    __m256i offset = _mm256_sub_epi8(v, digitBase);
+    __m256i digit = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, nine), offset);
+
+    uint32_t other = ~(uint32_t)_mm256_movemask_epi8(digit);
+    if(!found && other != 0){
+      *nonDigit = i + __builtin_ctz(other);
+      found = true;
+    }
+    uint32_t mask = _mm256_movemask_epi8(stop);
+    if(mask != 0) return i + __builtin_ctz(mask);
+  }
+
+  size_t restNonDigit;
+  size_t rest = fieldSse2(s + i, length - i, &restNonDigit);
+  if(!found) *nonDigit = i + restNonDigit;
+  return i + rest;
+}
+
+// Pola są zwykle krótkie, więc AVX2 opłaca się dopiero dla dłuższych fragmentów.
+static bool useAvx2(size_t length){
+  return length >= 64 && __builtin_cpu_supports("avx2");
+}
+
+size_t scanControl(const char *s, size_t length){
+  if(useAvx2(length)) return controlAvx2(s, length);
+  return controlSse2(s, length);
+}
+
+size_t scanField(const char *s, size_t length, size_t *nonDigit){
+  if(useAvx2(length)) return fieldAvx2(s, length, nonDigit);
+  return fieldSse2(s, length, nonDigit);
+}
+
+#else
+
+size_t scanControl(const char *s, size_t length){
+  return controlTail(s, 0, length);
+}
+
+size_t scanField(const char *s, size_t length, size_t *nonDigit){
+  return fieldTail(s, 0, length, false, nonDigit);
+}
+
+#endif
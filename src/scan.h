@@ -0,0 +1,33 @@
+/** @file
+ * Wyszukiwanie znaków w liniach wejścia po wiele bajtów naraz (SSE2, a jeśli
+ * procesor je obsługuje – AVX2).
+ *
+ * @author Jakub Organa
+ * @date 17.10.2026
+ */
+
+#ifndef __SCAN_H__
+#define __SCAN_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdbool.h>
+
+/** @brief Znajduje pierwszy znak sterujący (o kodzie od 0 do 31).
+ * @param[in] s      - przeszukiwany fragment
+ * @param[in] length      - długość fragmentu
+ * @return Zwraca pozycję znaku, lub length jeśli we fragmencie go nie ma.
+ */
+size_t scanControl(const char *s, size_t length);
+
+/** @brief Znajduje koniec pola linii: pierwszy średnik lub znak sterujący.
+ * @param[in] s      - przeszukiwany fragment
+ * @param[in] length      - długość fragmentu
+ * @param[out] nonDigit      - tu zostanie zapisana pozycja pierwszego znaku niebędącego
+ * cyfrą (nie większa niż zwracana pozycja)
+ * @return Zwraca pozycję znaku kończącego pole, lub length jeśli we fragmencie go nie ma.
+ */
+size_t scanField(const char *s, size_t length, size_t *nonDigit);
+
+#endif /* __SCAN_H__ */
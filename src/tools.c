@@ -5,345 +5,869 @@
 #include <stdbool.h>
 #include <inttypes.h>
 #include "types.h"
+#include "tools.h"
+#include "hash.h"
+#include "heap.h"
+#include "graph.h"
+#include "hierarchy.h"
 
 static const uint64_t INFINITY = 9223372036854775807;
 static const int32_t NEG_INFINITY = -2147483648;
 static const int32_t POS_INFINITY = 2147483647;
 
-//TREAP
+void deleteCity(Pools *pools, City *cityPtr){
+  cityPtr->name = NULL;
 
-int32_t compare(void *ptrA, void *ptrB, int32_t compareId){
-  // 1: City
-  if(compareId == 1){
-    return strcmp(((City*)ptrA)->name, ((City*)ptrB)->name);
-  }
+  poolFree(&(pools->cities), cityPtr);
+}
 
-  // 2: Neigh
-  if(compareId == 2){
-    return strcmp(((Neigh*)ptrA)->dest->name, ((Neigh*)ptrB)->dest->name);
-  }
+//DIJKSTRA
 
-  // 3: dijkVal
-  if(compareId == 3){
-    uint64_t distA = ((dijkVal*)ptrA)->actDist;
-    uint64_t distB = ((dijkVal*)ptrB)->actDist;
+void searchStateInit(SearchState *state, QueueKind kind){
+  state->epoch = 0;
+  state->capacity = 0;
+  state->seen = NULL;
+  state->settled = NULL;
+  state->dist = NULL;
+  state->youngestOldest = NULL;
+  state->secondOldest = NULL;
+  state->inCount = NULL;
+  state->pred = NULL;
+  state->order = NULL;
+  state->potential = NULL;
+  state->settledCount = 0;
+  state->landmarks = NULL;
+  state->goal = 0;
+  state->avoided = NULL;
+  state->allowed = UINT32_MAX;
+  pqInit(&(state->queue), kind);
+}
 
-    if(distA > distB) return 1;
-    if(distA == distB) return 0;
-    if(distA < distB) return -1;
-  }
+void searchStateFree(SearchState *state){
+  free(state->seen);
+  free(state->settled);
+  free(state->dist);
+  free(state->youngestOldest);
+  free(state->secondOldest);
+  free(state->inCount);
+  free(state->pred);
+  free(state->order);
+  free(state->potential);
+  pqFree(&(state->queue));
+  searchStateInit(state, state->queue.kind);
+}
+
+static bool growArray(void **array, uint32_t capacity, size_t size){
+  void *newArray = realloc(*array, capacity * size);
+  if(newArray == NULL) return false;
+  *array = newArray;
+  return true;
+}
 
-  // 4: strings
-  if(compareId == 4){
-    return strcmp((char*)ptrA, (char*)ptrB);
+static bool searchReserve(SearchState *state, uint32_t count){
+  if(count <= state->capacity) return true;
+
+  uint32_t capacity = state->capacity == 0 ? 64 : state->capacity;
+  while(capacity < count) capacity *= 2;
+
+  if(!growArray((void**)&(state->seen), capacity, sizeof(uint32_t))) return false;
+  if(!growArray((void**)&(state->settled), capacity, sizeof(uint32_t))) return false;
+  if(!growArray((void**)&(state->dist), capacity, sizeof(uint64_t))) return false;
+  if(!growArray((void**)&(state->youngestOldest), capacity, sizeof(int32_t))) return false;
+  if(!growArray((void**)&(state->secondOldest), capacity, sizeof(int32_t))) return false;
+  if(!growArray((void**)&(state->inCount), capacity, sizeof(int32_t))) return false;
+  if(!growArray((void**)&(state->pred), capacity, sizeof(uint32_t))) return false;
+  if(!growArray((void**)&(state->order), capacity, sizeof(uint32_t))) return false;
+  if(!growArray((void**)&(state->potential), capacity, sizeof(uint64_t))) return false;
+
+  for(uint32_t id = state->capacity; id < capacity; id++){
+    state->seen[id] = 0;
+    state->settled[id] = 0;
   }
+  state->capacity = capacity;
+  return true;
+}
 
-  return 0;
+static void searchBegin(SearchState *state){
+  state->settledCount = 0;
+  state->landmarks = NULL;
+  state->avoided = NULL;
+  state->allowed = UINT32_MAX;
+  state->epoch++;
+  if(state->epoch == 0){
+    for(uint32_t id = 0; id < state->capacity; id++){
+      state->seen[id] = 0;
+      state->settled[id] = 0;
+    }
+    state->epoch = 1;
+  }
 }
 
-void rightRotate(TreapNode **treapPtr){
-  TreapNode *y = *treapPtr;
-  TreapNode *x = y->left;
-  TreapNode *T2 = x->right;
+static uint64_t landmarkBound(Landmarks *landmarks, uint32_t id, uint32_t goal){
+  uint64_t bound = 0;
+  for(uint32_t l = 0; l < landmarks->count; l++){
+    uint64_t *dist = landmarks->dist + (size_t)l * landmarks->rows;
+    if(dist[id] == INFINITY || dist[goal] == INFINITY) continue;
 
-  x->right = y;
-  y->left = T2;
+    uint64_t diff = dist[id] > dist[goal] ? dist[id] - dist[goal] : dist[goal] - dist[id];
+    if(diff > bound) bound = diff;
+  }
+  return bound;
+}
 
-  *treapPtr = x;
+static bool isAvoided(SearchState *state, uint32_t id){
+  return state->avoided != NULL && id != state->allowed && cityIndexHas(state->avoided, id);
 }
 
-void leftRotate(TreapNode **treapPtr){
-  TreapNode *x = *treapPtr;
-  TreapNode *y = x->right;
-  TreapNode *T2 = y->left;
+static void touch(SearchState *state, uint32_t id){
+  if(state->seen[id] == state->epoch) return;
+  state->seen[id] = state->epoch;
+  state->dist[id] = INFINITY;
+  state->youngestOldest[id] = NEG_INFINITY;
+  state->inCount[id] = 0;
+  state->potential[id] = state->landmarks == NULL ? 0 : landmarkBound(state->landmarks, id, state->goal);
+}
 
-  y->left = x;
-  x->right = T2;
+uint64_t searchDist(SearchState *state, City *cityPtr){
+  if(cityPtr->id >= state->capacity || state->seen[cityPtr->id] != state->epoch) return INFINITY;
+  return state->dist[cityPtr->id];
+}
 
-  *treapPtr = y;
+int32_t searchYoungestOldest(SearchState *state, City *cityPtr){
+  if(cityPtr->id >= state->capacity || state->seen[cityPtr->id] != state->epoch) return NEG_INFINITY;
+  return state->youngestOldest[cityPtr->id];
 }
 
-void *search(TreapNode *root, void *valPtr, int32_t compareId){
-  if(root == NULL || compare(valPtr, root->valPtr, compareId) == 0){
-    if(root != NULL) return root->valPtr;
-    return NULL;
+static bool mergeOldest(int32_t *first, int32_t *second, int32_t *count, int32_t oldest){
+  if(*count == 0){
+    *first = oldest;
+    *count = 1;
+    return true;
   }
 
-  if(compare(valPtr, root->valPtr, compareId) < 0){
-    return search(root->left, valPtr, compareId);
-  } else {
-    return search(root->right, valPtr, compareId);
+  if(*count == 1 || oldest > *second){
+    *second = oldest;
+    *count = 2;
   }
+  if(*second > *first){
+    int32_t pom = *first;
+    *first = *second;
+    *second = pom;
+    return true;
+  }
+  return false;
 }
 
-void *removeMin(TreapNode **treapPtr){
-  TreapNode *t = *treapPtr;
-  if(t->left == NULL){
-    *treapPtr = t->right;
-    void* answ = t->valPtr;
-    free(t);
-    return answ;
-  }
-  else {
-    return removeMin(&(t->left));
+static void addOldest(SearchState *state, uint32_t id, int32_t oldest, uint32_t via){
+  if(mergeOldest(&(state->youngestOldest[id]), &(state->secondOldest[id]), &(state->inCount[id]), oldest)){
+    state->pred[id] = via;
   }
 }
 
-bool insert(TreapNode **treapPtr, void *valPtr, int32_t compareId){
-  if(*treapPtr == NULL){
-    *treapPtr = createTreapNode(valPtr);
-    if(treapPtr == NULL) return false;
-    return true;
+static bool relaxEdges(SearchState *state, Graph *graph, uint32_t fromId, uint32_t forbidFrom, uint32_t forbidTo){
+  uint64_t dist = state->dist[fromId];
+  int32_t first = state->youngestOldest[fromId];
+  bool hasSecond = state->inCount[fromId] > 1;
+  int32_t second = state->secondOldest[fromId];
+
+  uint32_t end = graph->rowStart[fromId] + graph->rowSize[fromId];
+  for(uint32_t k = graph->rowStart[fromId]; k < end; k++){
+    uint32_t destId = graph->targets[k];
+    if(fromId == forbidFrom && destId == forbidTo) continue;
+    if(fromId == forbidTo && destId == forbidFrom) continue;
+
+    uint64_t potDist = dist + graph->lengths[k];
+    touch(state, destId);
+    if(potDist > state->dist[destId] || isAvoided(state, destId)) continue;
+
+    if(potDist < state->dist[destId]){
+      state->dist[destId] = potDist;
+      state->inCount[destId] = 0;
+      if(!pqPush(&(state->queue), potDist + state->potential[destId], potDist, destId)) return false;
+    }
+
+    addOldest(state, destId, min(first, graph->years[k]), k);
+    if(hasSecond) addOldest(state, destId, min(second, graph->years[k]), k);
   }
+  return true;
+}
 
-  bool ret = true;
-  if(compare(valPtr, (*treapPtr)->valPtr, compareId) < 0){
-    ret = insert(&((*treapPtr)->left), valPtr, compareId);
+static bool startSearch(SearchState *state, uint32_t startId){
+  touch(state, startId);
+  state->dist[startId] = 0;
+  state->youngestOldest[startId] = POS_INFINITY;
+  state->inCount[startId] = 1;
+  return pqPush(&(state->queue), state->potential[startId], 0, startId);
+}
 
-    if((*treapPtr)->left->priority > (*treapPtr)->priority){
-      rightRotate(treapPtr);
-    }
-  } else {
-    ret = insert(&((*treapPtr)->right), valPtr, compareId);
+// Usuwa z kolejki nieaktualne wpisy; jeśli zostało w niej nieustalone miasto,
+// to wpis najbliższego z nich jest w nearest.
+static bool peekNearest(SearchState *state, bool *found, QueueEntry *nearest){
+  PQueue *queue = &(state->queue);
+  *found = false;
 
-    if((*treapPtr)->right->priority > (*treapPtr)->priority){
-      leftRotate(treapPtr);
+  while(!pqEmpty(queue)){
+    if(!pqTop(queue, nearest)) return false;
+
+    uint32_t id = nearest->item;
+    if(state->settled[id] != state->epoch && nearest->tie == state->dist[id]){
+      *found = true;
+      return true;
     }
+    if(!pqPop(queue, nearest)) return false;
   }
+  return true;
+}
 
-  return ret;
+static bool settleNearest(SearchState *state, uint32_t *id){
+  QueueEntry nearest;
+  if(!pqPop(&(state->queue), &nearest)) return false;
+
+  *id = nearest.item;
+  state->settled[*id] = state->epoch;
+  state->order[state->settledCount] = *id;
+  state->settledCount++;
+  return true;
 }
 
-void removeNode(TreapNode **treapPtr, void *valPtr, int32_t compareId){
-  if(*treapPtr == NULL){
-    return;
-  }
+// Dokleja na początek listy path odcinki najlepszej ścieżki od startu do miasta id.
+static bool prependBest(SearchState *state, Graph *graph, Pools *pools, uint32_t startId, uint32_t id, ListNode **path){
+  while(id != startId){
+    Neigh *actNeighPtr = graph->edges[state->pred[id]];
+    ListNode *prevListNode = createListNode(pools, actNeighPtr);
+    if(prevListNode == NULL) return false;
 
-  if(compare(valPtr, (*treapPtr)->valPtr, compareId) < 0){
-    removeNode(&((*treapPtr)->left), valPtr, compareId);
-  }
-  else if(compare(valPtr, (*treapPtr)->valPtr, compareId) > 0){
-    removeNode(&((*treapPtr)->right), valPtr, compareId);
+    prevListNode->next = *path;
+    *path = prevListNode;
+    id = actNeighPtr->reversed->dest->id;
   }
+  return true;
+}
 
-  else if((*treapPtr)->left == NULL){
-    TreapNode *rChild = (*treapPtr)->right;
-    free(*treapPtr);
-    *treapPtr = rChild;
+// Sprawdza, czy do miasta targetId prowadzi jednoznacznie wyznaczona najlepsza ścieżka.
+static bool bestExists(SearchState *state, uint32_t targetId){
+  if(state->seen[targetId] != state->epoch || state->dist[targetId] == INFINITY) return false;
+  return state->inCount[targetId] < 2 || state->secondOldest[targetId] != state->youngestOldest[targetId];
+}
+
+static bool bestPath(SearchState *state, Graph *graph, Pools *pools, uint32_t startId, uint32_t targetId, ListNode **target){
+  *target = NULL;
+  if(!bestExists(state, targetId)) return true;
+
+  ListNode *path = NULL;
+  if(!prependBest(state, graph, pools, startId, targetId, &path)){
+    freeList(pools, path);
+    return false;
   }
-  else if((*treapPtr)->right == NULL){
-    TreapNode *lChild = (*treapPtr)->left;
-    free(*treapPtr);
-    *treapPtr = lChild;
+  *target = path;
+  return true;
+}
+
+// Ustala odległości miast (od miast już wstawionych do kolejki) aż do zdjęcia
+// z kolejki miasta targetId (lub do wyczerpania kolejki). Przy równych
+// kluczach pierwszeństwo ma miasto bliższe startowi, więc także z potencjałem
+// (o nieujemnych kosztach zredukowanych) w chwili ustalenia miasta wszystkie
+// najkrótsze ścieżki do niego są już uwzględnione – długości odcinków są
+// dodatnie.
+static bool continueSearch(SearchState *state, Graph *graph, uint32_t targetId, uint32_t forbidFrom, uint32_t forbidTo){
+  bool ok = true;
+
+  while(ok){
+    bool found;
+    QueueEntry nearest;
+    uint32_t id;
+    if(!peekNearest(state, &found, &nearest)){
+      ok = false;
+      break;
+    }
+    if(!found) break;
+    if(!settleNearest(state, &id)){
+      ok = false;
+      break;
+    }
+    if(id == targetId) break;
+    ok = relaxEdges(state, graph, id, forbidFrom, forbidTo);
   }
+  pqClear(&(state->queue));
+  return ok;
+}
 
-  else if((*treapPtr)->left->priority < (*treapPtr)->right->priority){
-    leftRotate(treapPtr);
-    removeNode(&((*treapPtr)->left), valPtr, compareId);
-  } else {
-    rightRotate(treapPtr);
-    removeNode(&((*treapPtr)->right), valPtr, compareId);
+static bool runSearch(SearchState *state, Graph *graph, uint32_t startId, uint32_t targetId, uint32_t forbidFrom, uint32_t forbidTo){
+  if(!startSearch(state, startId)){
+    pqClear(&(state->queue));
+    return false;
   }
+  return continueSearch(state, graph, targetId, forbidFrom, forbidTo);
 }
 
-void deleteTreap(TreapNode *root){
-  if(root == NULL) return;
+// Wyszukiwanie omija miasta drogi krajowej (poza allowed); miasto startowe
+// nie jest sprawdzane.
+static void avoidRoute(SearchState *state, const CityIndex *route, uint32_t allowed){
+  state->avoided = route;
+  state->allowed = allowed;
+}
 
-  deleteTreap(root->left);
-  deleteTreap(root->right);
+static bool searchShortestPath(City *cityPtr1, City *cityPtr2, const CityIndex *route, City *valCity, Neigh *forbidden, Graph *graph, Landmarks *landmarks, SearchState *state){
+  if(!searchReserve(state, graph->rows)) return false;
+  searchBegin(state);
+  avoidRoute(state, route, valCity == NULL ? UINT32_MAX : valCity->id);
 
-  free(root->valPtr);
-  root->valPtr = NULL;
-  root->left = NULL;
-  root->right = NULL;
+  uint32_t forbidFrom = UINT32_MAX;
+  uint32_t forbidTo = UINT32_MAX;
+  if(forbidden != NULL){
+    forbidFrom = forbidden->reversed->dest->id;
+    forbidTo = forbidden->dest->id;
+  }
 
-  free(root);
+  state->landmarks = landmarks;
+  state->goal = cityPtr2->id;
+  return runSearch(state, graph, cityPtr1->id, cityPtr2->id, forbidFrom, forbidTo);
 }
 
-void flat_deleteTreap(TreapNode *root){
-  if(root == NULL) return;
-  flat_deleteTreap(root->left);
-  flat_deleteTreap(root->right);
-  root->valPtr = NULL;
-  free(root);
+bool findShortestPath(City *cityPtr1, City *cityPtr2, const CityIndex *route, City *valCity, Neigh *forbidden, Graph *graph, Landmarks *landmarks, Pools *pools, SearchState *state, ListNode **target){
+  if(!searchShortestPath(cityPtr1, cityPtr2, route, valCity, forbidden, graph, landmarks, state)) return false;
+  return bestPath(state, graph, pools, cityPtr1->id, cityPtr2->id, target);
 }
 
-void deleteNeighTreap(TreapNode *root){
-  if(root == NULL) return;
-
-  deleteNeighTreap(root->left);
-  deleteNeighTreap(root->right);
-
-  deleteNeigh((Neigh*)(root->valPtr));
-  root->valPtr = NULL;
-  root->left = NULL;
-  root->right = NULL;
+// Przepisuje do nowej tablicy odcinki najlepszej ścieżki od startu do miasta
+// id; jeśli takiej ścieżki nie ma, edges jest równe NULL.
+static bool bestEdges(SearchState *state, Graph *graph, uint32_t startId, uint32_t id, Neigh ***edges, uint32_t *count){
+  *edges = NULL;
+  *count = 0;
+  if(!bestExists(state, id)) return true;
+
+  uint32_t length = 0;
+  for(uint32_t k = id; k != startId; k = graph->edges[state->pred[k]]->reversed->dest->id) length++;
+
+  Neigh **path = (Neigh**)malloc(length * sizeof(Neigh*));
+  if(path == NULL) return false;
+  for(uint32_t i = length; i > 0; i--){
+    path[i - 1] = graph->edges[state->pred[id]];
+    id = path[i - 1]->reversed->dest->id;
+  }
 
-  free(root);
+  *edges = path;
+  *count = length;
+  return true;
 }
 
-void deleteCity(City *cityPtr){
-  deleteNeighTreap(cityPtr->neighbours);
-  cityPtr->neighbours = NULL;
-  free(cityPtr->name);
-  cityPtr->name = NULL;
-
-  free(cityPtr);
+bool findShortestPathEdges(City *cityPtr1, City *cityPtr2, const CityIndex *route, City *valCity, Neigh *forbidden, Graph *graph, Landmarks *landmarks, SearchState *state, Neigh ***edges, uint32_t *count){
+  *edges = NULL;
+  *count = 0;
+  if(!searchShortestPath(cityPtr1, cityPtr2, route, valCity, forbidden, graph, landmarks, state)) return false;
+  return bestEdges(state, graph, cityPtr1->id, cityPtr2->id, edges, count);
 }
 
-void deleteCityTreap(TreapNode *root){
-  if(root == NULL) return;
+// Wyszukiwanie kończy się, gdy wszystkie miasta docelowe są ustalone; wartości
+// ustalonego miasta (także liczba najlepszych wariantów) są już ostateczne,
+// bo długości odcinków są dodatnie.
+bool findShortestPathsFrom(City *source, City **targets, uint32_t count, Graph *graph, SearchState *state, Neigh ***edges, uint32_t *lengths){
+  for(uint32_t k = 0; k < count; k++){
+    edges[k] = NULL;
+    lengths[k] = 0;
+  }
+  if(!searchReserve(state, graph->rows)) return false;
+  searchBegin(state);
+
+  uint32_t startId = source->id;
+  bool ok = startSearch(state, startId);
+  uint32_t next = 0;
+  while(ok){
+    while(next < count && state->settled[targets[next]->id] == state->epoch) next++;
+    if(next == count) break;
+
+    bool found;
+    QueueEntry nearest;
+    uint32_t id;
+    if(!peekNearest(state, &found, &nearest)){
+      ok = false;
+      break;
+    }
+    if(!found) break;
+    if(!settleNearest(state, &id)){
+      ok = false;
+      break;
+    }
+    ok = relaxEdges(state, graph, id, UINT32_MAX, UINT32_MAX);
+  }
+  pqClear(&(state->queue));
 
-  deleteCityTreap(root->right);
-  deleteCityTreap(root->left);
+  for(uint32_t k = 0; ok && k < count; k++){
+    ok = bestEdges(state, graph, startId, targets[k]->id, &(edges[k]), &(lengths[k]));
+  }
+  if(!ok){
+    for(uint32_t k = 0; k < count; k++){
+      free(edges[k]);
+      edges[k] = NULL;
+      lengths[k] = 0;
+    }
+  }
+  return ok;
+}
 
-  deleteCity((City*)(root->valPtr));
-  root->valPtr = NULL;
-  root->left = NULL;
-  root->right = NULL;
-  free(root);
+// Dokleja na koniec listy odcinki najlepszej ścieżki od startu do miasta id,
+// skierowane od miasta id do startu.
+static bool appendBestReversed(SearchState *state, Graph *graph, Pools *pools, uint32_t startId, uint32_t id, ListNode ***tail){
+  while(id != startId){
+    Neigh *actNeighPtr = graph->edges[state->pred[id]]->reversed;
+    ListNode *nextListNode = createListNode(pools, actNeighPtr);
+    if(nextListNode == NULL) return false;
+
+    **tail = nextListNode;
+    *tail = &(nextListNode->next);
+    id = actNeighPtr->dest->id;
+  }
+  return true;
 }
 
-//DIJKSTRA
+bool findExtension(City *begCity, City *endCity, City *cityPtr, const CityIndex *route, Graph *graph, Landmarks *landmarks, Pools *pools, SearchState *state, ListNode **target, bool *atBeginning){
+  if(!searchReserve(state, graph->rows)) return false;
+  searchBegin(state);
+  avoidRoute(state, route, UINT32_MAX);
+
+  // Oba końce są źródłami o odległości 0, więc najlepsze ścieżki do miasta
+  // są najlepszymi ścieżkami od któregokolwiek końca; remis między końcami
+  // wychodzi jako niejednoznaczność tak samo jak remis w obrębie jednego.
+  state->landmarks = landmarks;
+  state->goal = cityPtr->id;
+  if(!startSearch(state, begCity->id) || !startSearch(state, endCity->id)){
+    pqClear(&(state->queue));
+    return false;
+  }
+  if(!continueSearch(state, graph, cityPtr->id, UINT32_MAX, UINT32_MAX)) return false;
 
-void setToInfinity(TreapNode *treap){
-  if(treap == NULL) return;
-  setToInfinity(treap->left);
-  setToInfinity(treap->right);
+  uint32_t targetId = cityPtr->id;
+  *target = NULL;
+  if(state->seen[targetId] != state->epoch || state->dist[targetId] == INFINITY) return true;
+  if(state->inCount[targetId] > 1 && state->secondOldest[targetId] == state->youngestOldest[targetId]){
+    return true;
+  }
 
-  City *cityPtr = (City*)(treap->valPtr);
-  cityPtr->dijkDist = INFINITY;
-  cityPtr->dijkYoungestOldest = NEG_INFINITY;
-  cityPtr->isInRoute = false;
-  cityPtr->dijkInCount = 0;
+  uint32_t sourceId = targetId;
+  while(state->dist[sourceId] != 0) sourceId = graph->edges[state->pred[sourceId]]->reversed->dest->id;
+  *atBeginning = sourceId == begCity->id;
+
+  // Fragment dokładany na początku drogi krajowej prowadzi od nowego miasta
+  // do jej pierwszego miasta, a dokładany na końcu – od ostatniego miasta.
+  ListNode *path = NULL;
+  ListNode **tail = &path;
+  bool ok;
+  if(*atBeginning) ok = appendBestReversed(state, graph, pools, sourceId, targetId, &tail);
+  else ok = prependBest(state, graph, pools, sourceId, targetId, &path);
+  if(!ok){
+    freeList(pools, path);
+    return false;
+  }
+  *target = path;
+  return true;
 }
 
-bool dijkProcessCity(TreapNode **dijkTreapPtr, TreapNode *neighRoot, int32_t oldest, uint64_t dist){
-  if(neighRoot == NULL) return true;
+bool findDistance(City *cityPtr1, City *cityPtr2, Graph *graph, Landmarks *landmarks, SearchState *state){
+  if(!searchReserve(state, graph->rows)) return false;
+  searchBegin(state);
 
-  Neigh *rootVal = (Neigh*)(neighRoot->valPtr);
-  City *destCity = rootVal->dest;
+  state->landmarks = landmarks;
+  state->goal = cityPtr2->id;
+  return runSearch(state, graph, cityPtr1->id, cityPtr2->id, UINT32_MAX, UINT32_MAX);
+}
 
-  uint64_t potDist = dist + rootVal->length;
+// Przeszukuje graf jednocześnie od obu końców. Stany muszą być rozpoczęte
+// (searchBegin), a omijane miasta zablokowane w obu. Jeśli wyszukiwanie w przód
+// ustaliło miasto docelowe, to targetSettled jest true, a ścieżkę wyznaczają
+// poprzedniki w forward. W przeciwnym razie meetEdge to pozycja odcinka,
+// którym najlepsza ścieżka przechodzi od miast ustalonych w przód do miast
+// ustalonych wstecz. found informuje, czy ścieżka jest wyznaczona jednoznacznie.
+static bool searchBidirectional(SearchState *forward, SearchState *backward, Graph *graph, uint32_t startId, uint32_t targetId, uint32_t forbidFrom, uint32_t forbidTo, bool *targetSettled, uint32_t *meetEdge, bool *found){
+  bool ok = startSearch(forward, startId) && startSearch(backward, targetId);
+  uint64_t meeting = INFINITY;
+  *targetSettled = false;
+  *found = false;
+
+  // Kończymy, gdy suma promieni przekroczy długość najlepszego znanego
+  // połączenia: wtedy każda najkrótsza ścieżka przechodzi odcinkiem z miasta
+  // ustalonego w przód do miasta ustalonego tylko wstecz.
+  while(ok){
+    bool foundF, foundB;
+    QueueEntry topF, topB;
+    if(!peekNearest(forward, &foundF, &topF) || !peekNearest(backward, &foundB, &topB)){
+      ok = false;
+      break;
+    }
+    if(!foundF || !foundB || topF.tie + topB.tie > meeting) break;
 
-  if(!(rootVal->forbid) && destCity->isInRoute == false && potDist <= destCity->dijkDist){
-    uint64_t lastDijkDist = destCity->dijkDist;
-    destCity->dijkDist = potDist;
+    bool isForward = topF.tie <= topB.tie;
+    SearchState *side = isForward ? forward : backward;
+    SearchState *other = isForward ? backward : forward;
 
-    int32_t newOldest = min(oldest, rootVal->date);
+    uint32_t id;
+    if(!settleNearest(side, &id)){
+      ok = false;
+      break;
+    }
+    if(isForward && id == targetId){
+      *targetSettled = true;
+      break;
+    }
+    if(other->seen[id] == other->epoch && side->dist[id] + other->dist[id] < meeting){
+      meeting = side->dist[id] + other->dist[id];
+    }
+    ok = relaxEdges(side, graph, id, forbidFrom, forbidTo);
+  }
+  pqClear(&(forward->queue));
+  pqClear(&(backward->queue));
 
-    if(potDist == lastDijkDist){
-      int32_t old = destCity->dijkYoungestOldest;
-      destCity->dijkYoungestOldest = max(destCity->dijkYoungestOldest, newOldest);
+  if(!ok) return false;
+  if(*targetSettled){
+    *found = bestExists(forward, targetId);
+    return true;
+  }
 
-      if(newOldest == old) destCity->dijkInCount++;
-      if(newOldest > old) destCity->dijkInCount = 1;
-    } else {
-      destCity->dijkYoungestOldest = newOldest;
-      destCity->dijkInCount = 1;
+  uint64_t bestLength = INFINITY;
+  int32_t first = NEG_INFINITY;
+  int32_t second = NEG_INFINITY;
+  int32_t count = 0;
+
+  for(uint32_t i = 0; i < forward->settledCount; i++){
+    uint32_t u = forward->order[i];
+    int32_t a1 = forward->youngestOldest[u];
+    int32_t a2 = forward->secondOldest[u];
+    bool hasA2 = forward->inCount[u] > 1;
+
+    uint32_t end = graph->rowStart[u] + graph->rowSize[u];
+    for(uint32_t k = graph->rowStart[u]; k < end; k++){
+      uint32_t v = graph->targets[k];
+      if(forward->settled[v] == forward->epoch || backward->settled[v] != backward->epoch) continue;
+      if(u == forbidFrom && v == forbidTo) continue;
+      if(u == forbidTo && v == forbidFrom) continue;
+
+      uint64_t length = forward->dist[u] + graph->lengths[k] + backward->dist[v];
+      if(length > bestLength) continue;
+      if(length < bestLength){
+        bestLength = length;
+        count = 0;
+      }
+
+      int32_t year = graph->years[k];
+      int32_t c1 = backward->youngestOldest[v];
+      if(mergeOldest(&first, &second, &count, min(min(a1, year), c1))) *meetEdge = k;
+      if(hasA2) mergeOldest(&first, &second, &count, min(min(a2, year), c1));
+      if(backward->inCount[v] > 1){
+        mergeOldest(&first, &second, &count, min(min(a1, year), backward->secondOldest[v]));
+      }
     }
-
-    dijkVal *toInsert = createDijkVal(destCity, destCity->dijkDist, newOldest);
-    if(toInsert == NULL) return false;
-    if(!insert(dijkTreapPtr, toInsert, 3)) return false;
   }
 
-  bool l = dijkProcessCity(dijkTreapPtr, neighRoot->left, oldest, dist);
-  bool r = dijkProcessCity(dijkTreapPtr, neighRoot->right, oldest, dist);
-  return (l && r);
+  *found = bestLength != INFINITY && (count < 2 || first != second);
+  return true;
 }
 
-void chooseNeighbour(City *cityPtr, Neigh **neighPtr, TreapNode *neighRoot, int32_t youngestOldest, int32_t actOldest){
-  if(neighRoot == NULL) return;
+bool findShortestPathBidirectional(City *cityPtr1, City *cityPtr2, Graph *graph, Pools *pools, SearchState *forward, SearchState *backward, ListNode **target){
+  if(!searchReserve(forward, graph->rows) || !searchReserve(backward, graph->rows)) return false;
+  searchBegin(forward);
+  searchBegin(backward);
 
-  chooseNeighbour(cityPtr, neighPtr, neighRoot->left, youngestOldest, actOldest);
-  chooseNeighbour(cityPtr, neighPtr, neighRoot->right, youngestOldest, actOldest);
+  uint32_t startId = cityPtr1->id;
+  uint32_t targetId = cityPtr2->id;
+  bool targetSettled, found;
+  uint32_t meetEdge = 0;
+  if(!searchBidirectional(forward, backward, graph, startId, targetId, UINT32_MAX, UINT32_MAX, &targetSettled, &meetEdge, &found)){
+    return false;
+  }
 
-  Neigh* rootVal = (Neigh*)(neighRoot->valPtr);
-  City *actNeighPtr = rootVal->dest;
+  *target = NULL;
+  if(!found) return true;
+  if(targetSettled) return bestPath(forward, graph, pools, startId, targetId, target);
 
-  if(!(rootVal->forbid) && cityPtr->dijkDist == actNeighPtr->dijkDist + rootVal->length){
-    int32_t newOldest = min(actOldest, rootVal->date);
+  ListNode *path = NULL;
+  ListNode **tail = &path;
+  if(!appendBestReversed(backward, graph, pools, targetId, graph->targets[meetEdge], &tail)){
+    freeList(pools, path);
+    return false;
+  }
 
-    if(min(newOldest, actNeighPtr->dijkYoungestOldest) == youngestOldest){
-      *neighPtr = rootVal;
+  Neigh *meetNeighPtr = graph->edges[meetEdge];
+  ListNode *meetListNode = createListNode(pools, meetNeighPtr);
+  if(meetListNode == NULL){
+    freeList(pools, path);
+    return false;
+  }
+  meetListNode->next = path;
+  path = meetListNode;
+
+  if(!prependBest(forward, graph, pools, startId, meetNeighPtr->reversed->dest->id, &path)){
+    freeList(pools, path);
+    return false;
+  }
+  *target = path;
+  return true;
+}
+
+bool findDetour(City *cityPtr1, City *cityPtr2, const CityIndex *route, Neigh *forbidden, Graph *graph, SearchState *forward, SearchState *backward, Neigh ***edges, uint32_t *count){
+  *edges = NULL;
+  *count = 0;
+  if(!searchReserve(forward, graph->rows) || !searchReserve(backward, graph->rows)) return false;
+  searchBegin(forward);
+  searchBegin(backward);
+
+  uint32_t startId = cityPtr1->id;
+  uint32_t targetId = cityPtr2->id;
+  avoidRoute(forward, route, targetId);
+  avoidRoute(backward, route, targetId);
+
+  uint32_t forbidFrom = forbidden->reversed->dest->id;
+  uint32_t forbidTo = forbidden->dest->id;
+  bool targetSettled, found;
+  uint32_t meetEdge = 0;
+  if(!searchBidirectional(forward, backward, graph, startId, targetId, forbidFrom, forbidTo, &targetSettled, &meetEdge, &found)){
+    return false;
+  }
+  if(!found) return true;
+
+  // Ścieżka składa się z odcinków prowadzących w przód do miasta meetId,
+  // odcinka meetEdge (jeśli wyszukiwania się spotkały) i odcinków wstecz.
+  uint32_t meetId = targetSettled ? targetId : graph->edges[meetEdge]->reversed->dest->id;
+  uint32_t forwardLength = 0;
+  for(uint32_t k = meetId; k != startId; k = graph->edges[forward->pred[k]]->reversed->dest->id) forwardLength++;
+  uint32_t length = forwardLength;
+  if(!targetSettled){
+    length++;
+    for(uint32_t k = graph->targets[meetEdge]; k != targetId; k = graph->edges[backward->pred[k]]->reversed->dest->id) length++;
+  }
+
+  Neigh **path = (Neigh**)malloc(length * sizeof(Neigh*));
+  if(path == NULL) return false;
+
+  for(uint32_t i = forwardLength, k = meetId; i > 0; i--){
+    path[i - 1] = graph->edges[forward->pred[k]];
+    k = path[i - 1]->reversed->dest->id;
+  }
+  if(!targetSettled){
+    path[forwardLength] = graph->edges[meetEdge];
+    for(uint32_t i = forwardLength + 1, k = graph->targets[meetEdge]; i < length; i++){
+      path[i] = graph->edges[backward->pred[k]]->reversed;
+      k = path[i]->dest->id;
     }
   }
+
+  *edges = path;
+  *count = length;
+  return true;
 }
 
-bool findShortestPath(City *cityPtr1, City *cityPtr2, ListNode *route, TreapNode *cities, City *valCity, ListNode **target){
-  setToInfinity(cities);
+// Dokleja na koniec listy odcinki ścieżki w górę hierarchii od startu do miasta id.
+static bool appendUpward(SearchState *state, Hierarchy *hierarchy, Pools *pools, uint32_t startId, uint32_t id, ListNode ***tail){
+  if(id == startId) return true;
 
-  if(route != NULL){
-    ((Neigh*)(route->valPtr))->reversed->dest->isInRoute = true;
+  uint32_t arc = hierarchy->upArcs[state->pred[id]];
+  HierarchyArc *arcPtr = &(hierarchy->arcs[arc]);
+  uint32_t prevId = arcPtr->from == id ? arcPtr->to : arcPtr->from;
+  if(!appendUpward(state, hierarchy, pools, startId, prevId, tail)) return false;
+  return hierarchyUnpack(hierarchy, arc, prevId, pools, tail);
+}
 
-    while(route != NULL){
-      ((Neigh*)(route->valPtr))->dest->isInRoute = true;
-      route = route->next;
-   }
+// Przeszukuje hierarchię w górę od obu końców i łączy wyniki w najwyższych
+// punktach ścieżek: wyznacza długość najlepszej ścieżki, dwie największe
+// wartości najstarszego odcinka (z krotnościami) i miasto, w którym
+// spotykają się połówki najlepszej ścieżki.
+static bool searchHierarchy(uint32_t startId, uint32_t targetId, Hierarchy *hierarchy, SearchState *forward, SearchState *backward, uint64_t *bestLength, int32_t *first, int32_t *second, int32_t *count, uint32_t *meetId){
+  Graph *up = &(hierarchy->up);
+  if(!searchReserve(forward, up->rows) || !searchReserve(backward, up->rows)) return false;
+  searchBegin(forward);
+  searchBegin(backward);
+
+  bool ok = startSearch(forward, startId) && startSearch(backward, targetId);
+  uint64_t meeting = INFINITY;
+
+  // Obie strony idą wyłącznie w górę hierarchii; kończymy, gdy żadna nie ma
+  // już miast bliższych niż najlepsze znane połączenie, bo każda najkrótsza
+  // ścieżka ma wtedy swój najwyższy punkt ustalony z obu stron.
+  while(ok){
+    bool foundF, foundB;
+    QueueEntry topF, topB;
+    if(!peekNearest(forward, &foundF, &topF) || !peekNearest(backward, &foundB, &topB)){
+      ok = false;
+      break;
+    }
+    if(!foundF && !foundB) break;
+
+    bool isForward = foundF && (!foundB || topF.tie <= topB.tie);
+    if((isForward ? topF.tie : topB.tie) > meeting) break;
+    SearchState *side = isForward ? forward : backward;
+    SearchState *other = isForward ? backward : forward;
+
+    uint32_t id;
+    if(!settleNearest(side, &id)){
+      ok = false;
+      break;
+    }
+    if(other->seen[id] == other->epoch && side->dist[id] + other->dist[id] < meeting){
+      meeting = side->dist[id] + other->dist[id];
+    }
+    ok = relaxEdges(side, up, id, UINT32_MAX, UINT32_MAX);
+  }
+  pqClear(&(forward->queue));
+  pqClear(&(backward->queue));
+  if(!ok) return false;
+
+  *bestLength = INFINITY;
+  *first = NEG_INFINITY;
+  *second = NEG_INFINITY;
+  *count = 0;
+  *meetId = 0;
+
+  for(uint32_t i = 0; i < forward->settledCount; i++){
+    uint32_t id = forward->order[i];
+    if(backward->settled[id] != backward->epoch) continue;
+
+    uint64_t length = forward->dist[id] + backward->dist[id];
+    if(length > *bestLength) continue;
+    if(length < *bestLength){
+      *bestLength = length;
+      *count = 0;
+    }
+
+    int32_t a1 = forward->youngestOldest[id];
+    int32_t c1 = backward->youngestOldest[id];
+    if(mergeOldest(first, second, count, min(a1, c1))) *meetId = id;
+    if(forward->inCount[id] > 1) mergeOldest(first, second, count, min(forward->secondOldest[id], c1));
+    if(backward->inCount[id] > 1) mergeOldest(first, second, count, min(a1, backward->secondOldest[id]));
   }
+  return true;
+}
 
-  if(valCity != NULL) valCity->isInRoute = false;
+bool distanceHierarchy(City *cityPtr1, City *cityPtr2, Hierarchy *hierarchy, SearchState *forward, SearchState *backward, uint64_t *dist, int32_t *youngestOldest){
+  int32_t second, count;
+  uint32_t meetId;
+  return searchHierarchy(cityPtr1->id, cityPtr2->id, hierarchy, forward, backward, dist, youngestOldest, &second, &count, &meetId);
+}
 
-  TreapNode *dijkTreap = NULL;
-  dijkVal *startCity = createDijkVal(cityPtr1, 0, POS_INFINITY);
-  if(startCity == NULL) return false;
-  cityPtr1->dijkDist = 0;
-  cityPtr1->dijkYoungestOldest = POS_INFINITY;
-  if(!insert(&dijkTreap, startCity, 3)){
-    free(startCity);
+bool findShortestPathHierarchy(City *cityPtr1, City *cityPtr2, const CityIndex *route, Hierarchy *hierarchy, Pools *pools, SearchState *forward, SearchState *backward, bool *decided, uint64_t *dist, int32_t *youngestOldest, ListNode **target){
+  uint32_t startId = cityPtr1->id;
+  uint32_t targetId = cityPtr2->id;
+  uint64_t bestLength;
+  int32_t first, second, count;
+  uint32_t meetId;
+  if(!searchHierarchy(startId, targetId, hierarchy, forward, backward, &bestLength, &first, &second, &count, &meetId)){
     return false;
   }
 
-  while(dijkTreap != NULL){
-    dijkVal *treapMin = (dijkVal*)removeMin(&dijkTreap);
-    City *nearestCity = treapMin->cityPtr;
-    int32_t oldest = treapMin->actOldest;
-    uint64_t dist = treapMin->actDist;
-    free(treapMin);
+  *target = NULL;
+  *dist = bestLength;
+  *youngestOldest = first;
+  *decided = true;
+  if(bestLength == INFINITY) return true;
 
-    if(!dijkProcessCity(&dijkTreap, nearestCity->neighbours, oldest, dist)){
-      deleteTreap(dijkTreap);
+  // Remis może wynikać także z kilku reprezentacji tej samej ścieżki, więc
+  // rozstrzyganie go zostawiamy zwykłemu wyszukiwaniu.
+  if(count > 1 && first == second){
+    *decided = false;
+    return true;
+  }
+
+  ListNode *path = NULL;
+  ListNode **tail = &path;
+  if(!appendUpward(forward, hierarchy, pools, startId, meetId, &tail)){
+    freeList(pools, path);
+    return false;
+  }
+  uint32_t id = meetId;
+  while(id != targetId){
+    uint32_t arc = hierarchy->upArcs[backward->pred[id]];
+    HierarchyArc *arcPtr = &(hierarchy->arcs[arc]);
+    if(!hierarchyUnpack(hierarchy, arc, id, pools, &tail)){
+      freeList(pools, path);
       return false;
     }
+    id = arcPtr->from == id ? arcPtr->to : arcPtr->from;
   }
 
-  deleteTreap(dijkTreap);
-  if(cityPtr2->dijkDist == INFINITY){
-    *target = NULL;
-    return true;
-  }
-  if(cityPtr2->dijkInCount > 1){
-    *target = NULL;
-    return true;
+  // Najlepsza ścieżka w całej sieci, omijająca drogę krajową, jest też
+  // najlepsza wśród ścieżek ją omijających; w przeciwnym razie wynik
+  // rozstrzyga zwykłe wyszukiwanie.
+  for(ListNode *ptr = path; route != NULL && ptr != NULL; ptr = ptr->next){
+    uint32_t id = ((Neigh*)(ptr->valPtr))->dest->id;
+    if(id != targetId && cityIndexHas(route, id)){
+      freeList(pools, path);
+      *decided = false;
+      return true;
+    }
   }
+  *target = path;
+  return true;
+}
 
-  ListNode *path = NULL;
-  int32_t youngestOldest = cityPtr2->dijkYoungestOldest;
-  int32_t oldest = POS_INFINITY;
-  Neigh *actNeighPtr = NULL;
-  City *actCityPtr = cityPtr2;
+//LANDMARKS
 
-  while(true){
-    if(actCityPtr == cityPtr1) break;
+void landmarksInit(Landmarks *landmarks, uint32_t count){
+  landmarks->count = count;
+  landmarks->rows = 0;
+  landmarks->cities = NULL;
+  landmarks->dist = NULL;
+  landmarks->stale = true;
+  landmarks->staleSearches = 0;
+}
 
-    actNeighPtr = NULL;
-    chooseNeighbour(actCityPtr, &actNeighPtr, actCityPtr->neighbours, youngestOldest, oldest);
-    oldest = min(oldest, actNeighPtr->date);
+void landmarksFree(Landmarks *landmarks){
+  free(landmarks->cities);
+  free(landmarks->dist);
+  landmarksInit(landmarks, landmarks->count);
+}
 
-    ListNode *prevListNode = createListNode(actNeighPtr->reversed);
+bool landmarksBuild(Landmarks *landmarks, Graph *graph, SearchState *state){
+  uint32_t rows = graph->rows;
+  uint32_t count = landmarks->count;
+  if(count == 0 || rows == 0){
+    landmarks->rows = rows;
+    landmarks->stale = false;
+    return true;
+  }
 
-    if(prevListNode == NULL){
-      freeList(path);
-      return false;
+  if(!searchReserve(state, rows)) return false;
+  uint32_t *cities = (uint32_t*)realloc(landmarks->cities, sizeof(uint32_t) * count);
+  if(cities == NULL) return false;
+  landmarks->cities = cities;
+  uint64_t *dist = (uint64_t*)realloc(landmarks->dist, sizeof(uint64_t) * count * rows);
+  if(dist == NULL) return false;
+  landmarks->dist = dist;
+  uint64_t *closest = (uint64_t*)malloc(sizeof(uint64_t) * rows);
+  if(closest == NULL) return false;
+
+  // Punkty wybieramy zachłannie: pierwszy to miasto najdalsze od miasta 0,
+  // a każdy kolejny to miasto najdalsze od dotychczas wybranych (miasta
+  // nieosiągalne z żadnego z nich mają pierwszeństwo).
+  searchBegin(state);
+  if(!runSearch(state, graph, 0, UINT32_MAX, UINT32_MAX, UINT32_MAX)){
+    free(closest);
+    return false;
+  }
+  for(uint32_t id = 0; id < rows; id++){
+    closest[id] = state->seen[id] == state->epoch ? state->dist[id] : 0;
+  }
+
+  for(uint32_t l = 0; l < count; l++){
+    uint32_t chosen = 0;
+    for(uint32_t id = 1; id < rows; id++){
+      if(closest[id] > closest[chosen]) chosen = id;
     }
+    cities[l] = chosen;
 
-    prevListNode->next = path;
-    path = prevListNode;
-    actCityPtr = actNeighPtr->dest;
+    searchBegin(state);
+    if(!runSearch(state, graph, chosen, UINT32_MAX, UINT32_MAX, UINT32_MAX)){
+      free(closest);
+      return false;
+    }
 
+    uint64_t *row = dist + (size_t)l * rows;
+    for(uint32_t id = 0; id < rows; id++){
+      row[id] = state->seen[id] == state->epoch ? state->dist[id] : INFINITY;
+      if(l == 0 || row[id] < closest[id]) closest[id] = row[id];
+    }
   }
-  *target = path;
+  free(closest);
+
+  landmarks->rows = rows;
+  landmarks->stale = false;
+  landmarks->staleSearches = 0;
   return true;
 }
 
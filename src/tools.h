@@ -13,52 +13,94 @@
 #include <inttypes.h>
 #include <stdbool.h>
 #include "types.h"
+#include "hash.h"
+#include "heap.h"
+#include "graph.h"
+#include "hierarchy.h"
 
-/** @brief Wyszukuje element w treapie.
- * Na podstawie wartości compareId wyszukuje podanym treapie element.
- * @param[in] root      - wskaźnik na korzeń treapa
- * @param[in] valPtr      - wskaźnik na strukturę o wartości, którą należy wyszukać.
- * @param[in] compareId      - informuje komparator jakiego typu są wartości w treapie.
- * @return wskaźnik na strukturę wyszukaną w treapie
+/** @brief Usuwa miasto.
+ * Oddaje miasto do puli. Nazwa miasta pozostaje w arenie nazw do usunięcia mapy.
+ * @param[in, out] pools      - wskaźnik na pule pamięci
+ * @param[in] cityPtr      - wkaźnik na miasto
  */
-void *search(TreapNode *root, void *valPtr, int32_t compareId);
+void deleteCity(Pools *pools, City *cityPtr);
 
-/** @brief Dodaje element do treapa.
- * Na podstawie wartości compareId dodaje do treapa nowy element zawierający
- * wskaźnik na wskazaną strukturę.
- * @param[in, out] treapPtr      - podwójny wskaźnik na korzeń treapa
- * @param[in] valPtr      - wskaźnik na strukturę, którą należy dodać
- * @param[in] compareId      - informuje komparator jakiego typu są wartości w treapie.
- * @return zwraca true jeśli udało się dodać element, lub false jeśli nie udało się zaalokować pamięci.
+/**
+ * Punkty orientacyjne (landmarks) wraz z odległościami od nich do wszystkich
+ * miast. Z nierówności trójkąta |d(L, x) - d(L, t)| jest dolnym
+ * ograniczeniem odległości z x do t, co pozwala prowadzić wyszukiwanie A*.
+ * Usunięcie odcinka nie psuje ograniczeń (odległości mogą tylko wzrosnąć),
+ * ale dodanie odcinka czyni tablice nieaktualnymi.
  */
-bool insert(TreapNode **treapPtr, void *valPtr, int32_t compareId);
+typedef struct Landmarks {
+  /*@{*/
+  uint32_t count; /**< liczba punktów orientacyjnych (0 oznacza wyszukiwanie bez nich) */
+  uint32_t rows; /**< liczba miast, dla których policzono odległości */
+  uint32_t *cities; /**< identyfikatory miast będących punktami orientacyjnymi */
+  uint64_t *dist; /**< odległości: dist[l * rows + id] dla punktu l i miasta id */
+  bool stale; /**< informacja, czy tablice wymagają przeliczenia */
+  uint32_t staleSearches; /**< liczba wyszukiwań wykonanych bez tablic od chwili, gdy stały się nieaktualne */
+  /*@}*/
+} Landmarks;
 
-/** @brief Usuwa element z treapa.
- * Na podstawie wartości compareId usuwa z treapa element zawierający wskaźnik
- * na wskazaną strukturę.
- * @param[in, out] treapPtr      - podwójny wskaźnik na korzeń treapa
- * @param[in] valPtr      - wskaźnik na strukturę, którą należy usunąć
- * @param[in] compareId      - nformuje komparator jakiego typu są wartości w treapie.
+/**
+ * Stan roboczy algorytmu Dijkstry. Wartości w tablicach indeksowanych
+ * identyfikatorami miast są ważne tylko wtedy, gdy ich znacznik jest równy
+ * numerowi bieżącego wyszukiwania, dzięki czemu wyszukiwanie odwiedza jedynie
+ * te miasta, do których faktycznie dociera.
+ *
+ * Dla każdego miasta pamiętane są dwie największe wartości najstarszego
+ * odcinka wśród najkrótszych ścieżek do niego (z krotnościami). Ścieżka
+ * najlepsza jest niejednoznaczna dokładnie wtedy, gdy obie są równe;
+ * w przeciwnym razie odtwarza się ją po zapamiętanych odcinkach pred.
  */
-void removeNode(TreapNode **treapPtr, void *valPtr, int32_t compareId);
+typedef struct SearchState {
+  /*@{*/
+  uint32_t epoch; /**< numer bieżącego wyszukiwania */
+  uint32_t capacity; /**< rozmiar tablic */
+  uint32_t *seen; /**< numer wyszukiwania, w którym miasto zostało osiągnięte */
+  uint32_t *settled; /**< numer wyszukiwania, w którym odległość miasta została ustalona */
+  uint64_t *dist; /**< odległość na ścieżce */
+  int32_t *youngestOldest; /**< najmłodszy z najstarszych na najkrótszych ścieżkach */
+  int32_t *secondOldest; /**< druga co do wielkości wartość najstarszego odcinka (gdy inCount wynosi 2) */
+  int32_t *inCount; /**< liczba najkrótszych ścieżek, które weszły do miasta, ograniczona do 2 */
+  uint32_t *pred; /**< pozycja w grafie odcinka, którym wchodzi do miasta najlepsza ścieżka */
+  uint32_t *order; /**< miasta w kolejności ustalania ich odległości */
+  uint64_t *potential; /**< dolne ograniczenie odległości z miasta do celu (0 bez punktów orientacyjnych) */
+  uint32_t settledCount; /**< liczba miast w tablicy order */
+  Landmarks *landmarks; /**< punkty orientacyjne używane w bieżącym wyszukiwaniu lub NULL */
+  uint32_t goal; /**< miasto docelowe bieżącego wyszukiwania z punktami orientacyjnymi */
+  const CityIndex *avoided; /**< miasta omijane w bieżącym wyszukiwaniu lub NULL */
+  uint32_t allowed; /**< miasto ze zbioru avoided, przez które wolno przechodzić (lub UINT32_MAX) */
+  PQueue queue; /**< kolejka priorytetowa */
+  /*@}*/
+} SearchState;
 
-/** @brief Usuwa z pamięci treapa, nie usuwając jednak structów w nim przechowywanych.
- * @param[in, out] root      - wskaźnik na korzeń treapa
+/** @brief Inicjalizuje pusty stan wyszukiwania.
+ * @param[out] state      - wskaźnik na stan
+ * @param[in] kind      - rodzaj kolejki priorytetowej
  */
-void flat_deleteTreap(TreapNode *root);
+void searchStateInit(SearchState *state, QueueKind kind);
 
-/** @brief Usuwa miasto.
- * Usuwa z pamięci miasto, a w tym jego nazwę.
- * @param[in] cityPtr      - wkaźnik na miasto
+/** @brief Zwalnia pamięć stanu wyszukiwania.
+ * @param[in, out] state      - wskaźnik na stan
  */
-void deleteCity(City *cityPtr);
+void searchStateFree(SearchState *state);
 
-/** @brief Usuwa treap zawierający miasta.
- * Usuwa treap zawierający miasta, a także dla każdego miasta usuwa treap
- * zawierający sąsiadów.
- * @param[in, out] root      - wkaźnik na korzeń treapa miast
+/** @brief Podaje odległość miasta wyznaczoną w ostatnim wyszukiwaniu.
+ * @param[in] state      - wskaźnik na stan
+ * @param[in] cityPtr      - wskaźnik na miasto
+ * @return Odległość lub INT64_MAX, jeśli miasto nie zostało osiągnięte.
  */
-void deleteCityTreap(TreapNode *root);
+uint64_t searchDist(SearchState *state, City *cityPtr);
+
+/** @brief Podaje najmłodszy z najstarszych odcinków na najlepszej ścieżce do
+ * miasta wyznaczonej w ostatnim wyszukiwaniu.
+ * @param[in] state      - wskaźnik na stan
+ * @param[in] cityPtr      - wskaźnik na miasto
+ * @return Rok lub INT32_MIN, jeśli miasto nie zostało osiągnięte.
+ */
+int32_t searchYoungestOldest(SearchState *state, City *cityPtr);
 
 /** @brief Znajduje ścieżkę między podanymi miastami.
  * Znajduje najlepszą ścieżkę (o właściwościach opisanym w dokumentacji map.h),
@@ -66,13 +108,178 @@ void deleteCityTreap(TreapNode *root);
  * wskazanego przez valCity
  * @param[in] cityPtr1      - wskaznik na miasto startowe
  * @param[in] cityPtr2      - wskaznik na miasto docelowe
- * @param[in] route      - wskaznik na drogę krajową, przez którą ścieżka nie może przechodzić
- * @param[in] cities      - wskaźnik na korzeń treapa miast
+ * @param[in] route      - wskaźnik na indeks miast drogi krajowej, przez które ścieżka nie może przechodzić
  * @param[in] valCity      - wskaźnik na miasto należące do drogi krajowej, przez które droga może przechodzić
+ * @param[in] forbidden      - wskaźnik na odcinek, którego ścieżka nie może używać (w żadnym kierunku), lub NULL
+ * @param[in] graph      - wskaźnik na aktualną reprezentację sieci dróg
+ * @param[in] landmarks      - wskaźnik na aktualne punkty orientacyjne, lub NULL dla zwykłego algorytmu Dijkstry
+ * @param[in, out] pools      - wskaźnik na pule pamięci
+ * @param[in, out] state      - wskaźnik na stan wyszukiwania
  * @param[out] target      - podwójny wskaźnik na listę, w której będzie zapisany wynik
  * @return Zwraca true jeśli udało się wyznaczyć ścieżkę, lub false jeśli nie udało się zaalokować pamięci.
  */
-bool findShortestPath(City *cityPtr1, City *cityPtr2, ListNode *route, TreapNode *cities, City *valCity, ListNode **target);
+bool findShortestPath(City *cityPtr1, City *cityPtr2, const CityIndex *route, City *valCity, Neigh *forbidden, Graph *graph, Landmarks *landmarks, Pools *pools, SearchState *state, ListNode **target);
+
+/** @brief Znajduje fragment, o który należy wydłużyć drogę krajową.
+ * Jedno wyszukiwanie startuje jednocześnie z obu końców drogi krajowej i
+ * wyznacza najlepszą ścieżkę do podanego miasta, nieprzechodzącą przez inne
+ * miasta drogi krajowej. Jeśli najlepsze ścieżki z obu końców są równie
+ * dobre, wynik jest niejednoznaczny.
+ * @param[in] begCity      - wskaźnik na pierwsze miasto drogi krajowej
+ * @param[in] endCity      - wskaźnik na ostatnie miasto drogi krajowej
+ * @param[in] cityPtr      - wskaźnik na miasto, do którego wydłużamy drogę krajową
+ * @param[in] route      - wskaźnik na indeks miast drogi krajowej
+ * @param[in] graph      - wskaźnik na aktualną reprezentację sieci dróg
+ * @param[in] landmarks      - wskaźnik na aktualne punkty orientacyjne, lub NULL dla zwykłego algorytmu Dijkstry
+ * @param[in, out] pools      - wskaźnik na pule pamięci
+ * @param[in, out] state      - wskaźnik na stan wyszukiwania
+ * @param[out] target      - podwójny wskaźnik na listę, w której będzie zapisany fragment (NULL, jeśli
+ * nie ma go lub nie jest wyznaczony jednoznacznie): od miasta cityPtr do begCity albo od endCity do cityPtr
+ * @param[out] atBeginning      - informacja, czy fragment należy dołączyć na początku drogi krajowej
+ * @return Zwraca true jeśli udało się wyznaczyć ścieżkę, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool findExtension(City *begCity, City *endCity, City *cityPtr, const CityIndex *route, Graph *graph, Landmarks *landmarks, Pools *pools, SearchState *state, ListNode **target, bool *atBeginning);
+
+/** @brief Wyznacza odległość między podanymi miastami, nie odtwarzając ścieżki.
+ * Wynik jest dostępny przez searchDist i searchYoungestOldest dla miasta docelowego.
+ * @param[in] cityPtr1      - wskaznik na miasto startowe
+ * @param[in] cityPtr2      - wskaznik na miasto docelowe
+ * @param[in] graph      - wskaźnik na aktualną reprezentację sieci dróg
+ * @param[in] landmarks      - wskaźnik na aktualne punkty orientacyjne, lub NULL dla zwykłego algorytmu Dijkstry
+ * @param[in, out] state      - wskaźnik na stan wyszukiwania
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool findDistance(City *cityPtr1, City *cityPtr2, Graph *graph, Landmarks *landmarks, SearchState *state);
+
+/** @brief Znajduje ścieżkę między podanymi miastami tak jak findShortestPath,
+ * ale zapisuje ją w tablicy zamiast w liście.
+ * Nie korzysta z pul pamięci mapy ani nie zmienia sieci dróg, więc wiele
+ * wywołań z różnymi stanami wyszukiwania może działać jednocześnie.
+ * @param[in] cityPtr1      - wskaznik na miasto startowe
+ * @param[in] cityPtr2      - wskaznik na miasto docelowe
+ * @param[in] route      - wskaźnik na indeks miast drogi krajowej, przez które ścieżka nie może przechodzić
+ * @param[in] valCity      - wskaźnik na miasto należące do drogi krajowej, przez które droga może przechodzić
+ * @param[in] forbidden      - wskaźnik na odcinek, którego ścieżka nie może używać (w żadnym kierunku), lub NULL
+ * @param[in] graph      - wskaźnik na aktualną reprezentację sieci dróg
+ * @param[in] landmarks      - wskaźnik na aktualne punkty orientacyjne, lub NULL dla zwykłego algorytmu Dijkstry
+ * @param[in, out] state      - wskaźnik na stan wyszukiwania
+ * @param[out] edges      - tu zostanie zapisana zaalokowana tablica kolejnych odcinków ścieżki
+ * (do zwolnienia przez wywołującego), lub NULL jeśli ścieżki nie ma lub nie jest wyznaczona jednoznacznie
+ * @param[out] count      - liczba odcinków ścieżki
+ * @return Zwraca true jeśli udało się wyznaczyć ścieżkę, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool findShortestPathEdges(City *cityPtr1, City *cityPtr2, const CityIndex *route, City *valCity, Neigh *forbidden, Graph *graph, Landmarks *landmarks, SearchState *state, Neigh ***edges, uint32_t *count);
+
+/** @brief Znajduje najlepsze ścieżki z jednego miasta do wielu miast.
+ * Dla każdego miasta docelowego wynik jest taki sam jak wynik
+ * findShortestPathEdges bez omijanej drogi krajowej, ale graf jest
+ * przeszukiwany tylko raz, aż do ustalenia wszystkich miast docelowych.
+ * @param[in] source      - wskaźnik na miasto startowe
+ * @param[in] targets      - tablica wskaźników na miasta docelowe
+ * @param[in] count      - liczba miast docelowych
+ * @param[in] graph      - wskaźnik na aktualną reprezentację sieci dróg
+ * @param[in, out] state      - wskaźnik na stan wyszukiwania
+ * @param[out] edges      - tablica, w której k-tym polu zostanie zapisana zaalokowana tablica
+ * odcinków ścieżki do k-tego miasta (do zwolnienia przez wywołującego), lub NULL jeśli
+ * ścieżki nie ma lub nie jest wyznaczona jednoznacznie
+ * @param[out] lengths      - tablica, w której zostaną zapisane liczby odcinków ścieżek
+ * @return Zwraca true jeśli udało się wyznaczyć ścieżki, lub false jeśli nie udało się
+ * zaalokować pamięci (wtedy wszystkie pola edges są równe NULL).
+ */
+bool findShortestPathsFrom(City *source, City **targets, uint32_t count, Graph *graph, SearchState *state, Neigh ***edges, uint32_t *lengths);
+
+/** @brief Znajduje ścieżkę między podanymi miastami, przeszukując graf
+ * jednocześnie od obu końców.
+ * Wynik jest taki sam jak wynik findShortestPath bez omijanej drogi krajowej:
+ * najkrótsza ścieżka, spośród nich ta o najmłodszym najstarszym odcinku, lub
+ * NULL, gdy takiej ścieżki nie ma albo nie jest wyznaczona jednoznacznie.
+ * @param[in] cityPtr1      - wskaznik na miasto startowe
+ * @param[in] cityPtr2      - wskaznik na miasto docelowe
+ * @param[in] graph      - wskaźnik na aktualną reprezentację sieci dróg
+ * @param[in, out] pools      - wskaźnik na pule pamięci
+ * @param[in, out] forward      - wskaźnik na stan wyszukiwania od miasta startowego
+ * @param[in, out] backward      - wskaźnik na stan wyszukiwania od miasta docelowego
+ * @param[out] target      - podwójny wskaźnik na listę, w której będzie zapisany wynik
+ * @return Zwraca true jeśli udało się wyznaczyć ścieżkę, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool findShortestPathBidirectional(City *cityPtr1, City *cityPtr2, Graph *graph, Pools *pools, SearchState *forward, SearchState *backward, ListNode **target);
+
+/** @brief Znajduje objazd drogi krajowej, przeszukując graf jednocześnie od
+ * obu jego końców.
+ * Wynik jest taki sam jak wynik findShortestPathEdges z miastem docelowym jako
+ * valCity, ale przeszukiwane są jedynie miasta bliższe któremuś z końców niż
+ * połowa długości objazdu, więc koszt zależy od otoczenia usuniętego odcinka,
+ * a nie od wielkości mapy. Funkcja nie korzysta z pul pamięci.
+ * @param[in] cityPtr1      - wskaznik na miasto startowe
+ * @param[in] cityPtr2      - wskaznik na miasto docelowe
+ * @param[in] route      - wskaźnik na indeks miast drogi krajowej, których ścieżka nie może zawierać
+ * (poza miastem docelowym)
+ * @param[in] forbidden      - wskaźnik na odcinek, którego ścieżka nie może używać (w żadnym kierunku)
+ * @param[in] graph      - wskaźnik na aktualną reprezentację sieci dróg
+ * @param[in, out] forward      - wskaźnik na stan wyszukiwania od miasta startowego
+ * @param[in, out] backward      - wskaźnik na stan wyszukiwania od miasta docelowego
+ * @param[out] edges      - tu zostanie zapisana zaalokowana tablica kolejnych odcinków ścieżki
+ * (do zwolnienia przez wywołującego), lub NULL jeśli ścieżki nie ma lub nie jest wyznaczona jednoznacznie
+ * @param[out] count      - liczba odcinków ścieżki
+ * @return Zwraca true jeśli udało się wyznaczyć ścieżkę, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool findDetour(City *cityPtr1, City *cityPtr2, const CityIndex *route, Neigh *forbidden, Graph *graph, SearchState *forward, SearchState *backward, Neigh ***edges, uint32_t *count);
+
+/** @brief Znajduje ścieżkę między podanymi miastami za pomocą hierarchii
+ * kontrakcyjnej i rozwija ją do odcinków dróg.
+ * Wyszukiwanie jest rozstrzygające, gdy najlepsza ścieżka w całej sieci jest
+ * wyznaczona jednoznacznie i nie przechodzi przez miasta omijanej drogi
+ * krajowej (poza miastem startowym i docelowym) albo gdy ścieżki nie ma;
+ * wynik jest wtedy taki sam jak wynik findShortestPath. W przeciwnym razie
+ * należy użyć zwykłego wyszukiwania.
+ * @param[in] cityPtr1      - wskaznik na miasto startowe
+ * @param[in] cityPtr2      - wskaznik na miasto docelowe
+ * @param[in] route      - wskaźnik na indeks miast drogi krajowej, przez które ścieżka nie może przechodzić, lub NULL
+ * @param[in] hierarchy      - wskaźnik na aktualną hierarchię
+ * @param[in, out] pools      - wskaźnik na pule pamięci
+ * @param[in, out] forward      - wskaźnik na stan wyszukiwania od miasta startowego
+ * @param[in, out] backward      - wskaźnik na stan wyszukiwania od miasta docelowego
+ * @param[out] decided      - informacja, czy wyszukiwanie było rozstrzygające
+ * @param[out] dist      - długość najlepszej ścieżki lub INT64_MAX, jeśli jej nie ma
+ * @param[out] youngestOldest      - najmłodszy z najstarszych odcinków na najlepszej ścieżce
+ * @param[out] target      - podwójny wskaźnik na listę, w której będzie zapisany wynik
+ * @return Zwraca true jeśli udało się wyznaczyć ścieżkę, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool findShortestPathHierarchy(City *cityPtr1, City *cityPtr2, const CityIndex *route, Hierarchy *hierarchy, Pools *pools, SearchState *forward, SearchState *backward, bool *decided, uint64_t *dist, int32_t *youngestOldest, ListNode **target);
+
+/** @brief Wyznacza odległość między podanymi miastami za pomocą hierarchii
+ * kontrakcyjnej, nie odtwarzając ścieżki.
+ * @param[in] cityPtr1      - wskaznik na miasto startowe
+ * @param[in] cityPtr2      - wskaznik na miasto docelowe
+ * @param[in] hierarchy      - wskaźnik na aktualną hierarchię
+ * @param[in, out] forward      - wskaźnik na stan wyszukiwania od miasta startowego
+ * @param[in, out] backward      - wskaźnik na stan wyszukiwania od miasta docelowego
+ * @param[out] dist      - długość najkrótszej ścieżki lub INT64_MAX, jeśli jej nie ma
+ * @param[out] youngestOldest      - najmłodszy z najstarszych odcinków na najkrótszych ścieżkach
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
+ */
+bool distanceHierarchy(City *cityPtr1, City *cityPtr2, Hierarchy *hierarchy, SearchState *forward, SearchState *backward, uint64_t *dist, int32_t *youngestOldest);
+
+/** @brief Inicjalizuje puste (nieaktualne) tablice punktów orientacyjnych.
+ * @param[out] landmarks      - wskaźnik na punkty orientacyjne
+ * @param[in] count      - liczba punktów orientacyjnych
+ */
+void landmarksInit(Landmarks *landmarks, uint32_t count);
+
+/** @brief Zwalnia pamięć tablic punktów orientacyjnych.
+ * @param[in, out] landmarks      - wskaźnik na punkty orientacyjne
+ */
+void landmarksFree(Landmarks *landmarks);
+
+/** @brief Wybiera punkty orientacyjne i liczy odległości od nich.
+ * Wykonuje jedno pełne wyszukiwanie na każdy punkt.
+ * @param[in, out] landmarks      - wskaźnik na punkty orientacyjne
+ * @param[in] graph      - wskaźnik na aktualną reprezentację sieci dróg
+ * @param[in, out] state      - wskaźnik na stan wyszukiwania używany do obliczeń
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci
+ * (tablice pozostają wtedy nieaktualne).
+ */
+bool landmarksBuild(Landmarks *landmarks, Graph *graph, SearchState *state);
 
 /** @brief Dodaje char do wskazanego stringa.
  * Dodaje znak do wskazanego stringa, w razie potrzeby realokouje pamięć.
@@ -6,9 +6,6 @@
 #include <inttypes.h>
 #include "types.h"
 
-static const uint64_t INFINITY = 9223372036854775807;
-static const int32_t NEG_INFINITY = -2147483648;
-
 int64_t min(int64_t a, int64_t b){
   if(a < b) return a;
   return b;
@@ -19,8 +16,24 @@ int64_t max(int64_t a, int64_t b){
   return b;
 }
 
-ListNode *createListNode(void *valPtr){
-  ListNode *newNode = (ListNode*)malloc(sizeof(ListNode));
+void poolsInit(Pools *pools){
+  poolInit(&(pools->cities), sizeof(City));
+  poolInit(&(pools->neighs), sizeof(Neigh));
+  poolInit(&(pools->routeSets), sizeof(RouteSet));
+  poolInit(&(pools->listNodes), sizeof(ListNode));
+  arenaInit(&(pools->names));
+}
+
+void poolsDestroy(Pools *pools){
+  poolDestroy(&(pools->cities));
+  poolDestroy(&(pools->neighs));
+  poolDestroy(&(pools->routeSets));
+  poolDestroy(&(pools->listNodes));
+  arenaDestroy(&(pools->names));
+}
+
+ListNode *createListNode(Pools *pools, void *valPtr){
+  ListNode *newNode = (ListNode*)poolAlloc(&(pools->listNodes));
   if(newNode == NULL) return NULL;
 
   newNode->valPtr = valPtr;
@@ -29,35 +42,24 @@ ListNode *createListNode(void *valPtr){
   return newNode;
 }
 
-dijkVal *createDijkVal(City *cityPtr, uint64_t actDist, int32_t actOldest){
-  dijkVal *newDijkVal = (dijkVal*)malloc(sizeof(dijkVal));
-  if(newDijkVal == NULL) return NULL;
-
-  newDijkVal->cityPtr = cityPtr;
-  newDijkVal->actDist = actDist;
-  newDijkVal->actOldest = actOldest;
-
-  return newDijkVal;
-}
-
-City *createCity(char *name){
-  City *newCity = (City*)malloc(sizeof(City));
+City *createCity(Pools *pools, const char *name){
+  City *newCity = (City*)poolAlloc(&(pools->cities));
   if(newCity == NULL) return NULL;
 
-  newCity->name = (char*)malloc(sizeof(char) * (strlen(name) + 1));
-  if(newCity->name == NULL) return NULL;
+  newCity->name = (char*)arenaAlloc(&(pools->names), sizeof(char) * (strlen(name) + 1));
+  if(newCity->name == NULL){
+    poolFree(&(pools->cities), newCity);
+    return NULL;
+  }
   strcpy(newCity->name, name);
-  newCity->neighbours = NULL;
-  newCity->dijkDist = INFINITY;
-  newCity->dijkYoungestOldest = NEG_INFINITY;
-  newCity->isInRoute = false;
-  newCity->dijkInCount = 0;
+  newCity->id = 0;
+  newCity->hash = 0;
 
   return newCity;
 }
 
-Neigh *createNeigh(City *cityPtr, uint32_t length, int32_t date){
-  Neigh *newNeigh = (Neigh*)malloc(sizeof(Neigh));
+Neigh *createNeigh(Pools *pools, City *cityPtr, uint32_t length, int32_t date){
+  Neigh *newNeigh = (Neigh*)poolAlloc(&(pools->neighs));
   if(newNeigh == NULL) return NULL;
 
   newNeigh->dest = cityPtr;
@@ -65,61 +67,77 @@ Neigh *createNeigh(City *cityPtr, uint32_t length, int32_t date){
   newNeigh->date = date;
   newNeigh->reversed = NULL;
   newNeigh->localRoutes = NULL;
-  newNeigh->forbid = false;
 
   return newNeigh;
 }
 
-TreapNode *createTreapNode(void *valPtr){
-  TreapNode *newTreapNode = (TreapNode*)malloc(sizeof(TreapNode));
-  if(newTreapNode == NULL) return NULL;
-
-  newTreapNode->valPtr = valPtr;
-  newTreapNode->priority = rand();
-  newTreapNode->left = NULL;
-  newTreapNode->right = NULL;
-
-  return newTreapNode;
-}
-
-void freeList(ListNode *path){
+void freeList(Pools *pools, ListNode *path){
   while(path != NULL){
     ListNode *p = path->next;
-    free(path);
+    poolFree(&(pools->listNodes), path);
     path = p;
   }
 }
 
-bool reverseNeighList(ListNode *listPtr, ListNode **target){
-  ListNode *newListPtr = NULL;
-  while(listPtr != NULL){
-    Neigh *rev = ((Neigh*)(listPtr->valPtr))->reversed;
-    ListNode *prevListNode = createListNode(rev);
-    if(prevListNode == NULL){
-      freeList(newListPtr);
-      return false;
-    }
-    prevListNode->next = newListPtr;
-    newListPtr = prevListNode;
-    listPtr = listPtr->next;
+void deleteNeigh(Pools *pools, Neigh *neighPtr){
+  if(neighPtr->reversed != NULL){
+    neighPtr->reversed->reversed = NULL;
+  } else if(neighPtr->localRoutes != NULL){
+    free(neighPtr->localRoutes->routeIds);
+    poolFree(&(pools->routeSets), neighPtr->localRoutes);
   }
+  neighPtr->localRoutes = NULL;
 
-  *target = newListPtr;
-  return true;
+  poolFree(&(pools->neighs), neighPtr);
 }
 
-void deleteNeigh(Neigh *neighPtr){
-  free(neighPtr->localRoutes);
-  neighPtr->localRoutes = NULL;
-
-  free(neighPtr);
-  neighPtr = NULL;
+static uint32_t routeSetLowerBound(RouteSet *set, uint32_t routeId){
+  uint32_t lo = 0;
+  uint32_t hi = set->size;
+  while(lo < hi){
+    uint32_t mid = lo + (hi - lo) / 2;
+    if(set->routeIds[mid] < routeId) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
 }
 
-bool neighRoutesInit(Neigh *ptr){
-  ptr->localRoutes = (bool*)malloc(sizeof(bool) * 1000);
-  if(ptr->localRoutes == NULL) return false;
+bool neighAddRoute(Pools *pools, Neigh *neighPtr, uint32_t routeId){
+  RouteSet *set = neighPtr->localRoutes;
+  if(set == NULL){
+    set = (RouteSet*)poolAlloc(&(pools->routeSets));
+    if(set == NULL) return false;
+    set->routeIds = NULL;
+    set->size = 0;
+    set->capacity = 0;
+    neighPtr->localRoutes = set;
+    neighPtr->reversed->localRoutes = set;
+  }
+
+  uint32_t i = routeSetLowerBound(set, routeId);
+  if(i < set->size && set->routeIds[i] == routeId) return true;
 
-  for(int i=0; i<1000; i++) ptr->localRoutes[i] = false;
+  if(set->size == set->capacity){
+    uint32_t newCapacity = set->capacity == 0 ? 2 : 2 * set->capacity;
+    uint32_t *newRouteIds = (uint32_t*)realloc(set->routeIds, newCapacity * sizeof(uint32_t));
+    if(newRouteIds == NULL) return false;
+    set->routeIds = newRouteIds;
+    set->capacity = newCapacity;
+  }
+
+  memmove(set->routeIds + i + 1, set->routeIds + i, (set->size - i) * sizeof(uint32_t));
+  set->routeIds[i] = routeId;
+  set->size++;
   return true;
 }
+
+void neighRemoveRoute(Neigh *neighPtr, uint32_t routeId){
+  RouteSet *set = neighPtr->localRoutes;
+  if(set == NULL) return;
+
+  uint32_t i = routeSetLowerBound(set, routeId);
+  if(i == set->size || set->routeIds[i] != routeId) return;
+
+  memmove(set->routeIds + i, set->routeIds + i + 1, (set->size - i - 1) * sizeof(uint32_t));
+  set->size--;
+}
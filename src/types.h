@@ -12,6 +12,7 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include <stdbool.h>
+#include "pool.h"
 
 /** @brief Znajduje minimalną wartość
  * @param[in] a      - wartość a
@@ -37,42 +38,29 @@ typedef struct ListNode {
   /*@}*/
 } ListNode;
 
-/**
- * Element treapa
- */
-typedef struct TreapNode {
-  /*@{*/
-  void *valPtr; /**< wartość */
-  int32_t priority; /**< priorytet */
-  struct TreapNode *left; /**< wskaźnik na lewego syna */
-  struct TreapNode *right; /**< wskaźnik na prawego syna */
-  /*@}*/
-} TreapNode;
-
 /**
  * Struktura reprezentująca miasto
  */
 typedef struct City {
   /*@{*/
   char *name; /**< nazwa miasta */
-  struct TreapNode *neighbours; /**< treap sąsiadów */
-  uint64_t dijkDist; /**< odległość na ścieżce (potrzebne do algorytmu Dijkstry) */
-  int32_t dijkYoungestOldest; /**< najmłodszy z najstarszych na ścieżce (generowane w trakcie algorytmu Dijkstry) */
-  bool isInRoute; /**< przechowuje informację, czy miasto znajduje się w aktualnie rozpatrywanej drodze krajowej */
-  int32_t dijkInCount; /**< liczba ścieżek, które weszły do tego miasta w trakcie algorytmu Dijkstry */
+  uint32_t id; /**< identyfikator miasta w tablicy miast mapy */
+  uint32_t hash; /**< wartość funkcji mieszającej dla nazwy miasta */
   /*@}*/
 } City;
 
 /**
- * Struktura przechowująca zakończenia ścieżek w trakcie algorytmu Dijksty
+ * Zbiór dróg krajowych przechodzących przez odcinek drogi. Numery dróg są
+ * posortowane i trzymane w tablicy alokowanej dopiero przy dodaniu pierwszej
+ * drogi krajowej.
  */
-typedef struct dijkVal{
+typedef struct RouteSet {
   /*@{*/
-  struct City *cityPtr; /**< wskaźnik na miasto */
-  uint64_t actDist; /**< aktualna odległość */
-  int32_t actOldest; /**< najstarszy na ścieżce */
+  uint32_t *routeIds; /**< posortowane numery dróg krajowych */
+  uint32_t size; /**< liczba dróg krajowych */
+  uint32_t capacity; /**< rozmiar tablicy routeIds */
   /*@}*/
-} dijkVal;
+} RouteSet;
 
 /**
  * Struktura reprezentująca odcinek drogi (skierowany)
@@ -83,66 +71,83 @@ typedef struct Neigh {
   uint32_t length; /**< długość */
   int32_t date; /**< rok budowy/ostatniego remontu */
   struct Neigh *reversed; /**< wkaźnik odpowiedni odcinek drogi skierowany przeciwnie */
-  bool *localRoutes; /**< tablica przechowująca informacje o drogach krajowych, które przechodzą przez odcinek */
-  bool forbid; /**< informacja dla algorytmu Dijksty, czy przejście przez dany odcinek jest zabronione */
+  RouteSet *localRoutes; /**< drogi krajowe przechodzące przez odcinek, wspólne dla obu kierunków (NULL jeśli brak) */
   /*@{*/
 } Neigh;
 
 
-/** @brief Tworzy nowy element typu ListNode
- * @param[in] valPtr      - wskaźnik na wartość
- * @return Zwraca wskaźnik na utworzony element.
+/**
+ * Pule pamięci mapy. Obiekty grafu i dróg krajowych są przydzielane z pul,
+ * a nazwy miast z areny.
+ */
+typedef struct Pools {
+  /*@{*/
+  Pool cities; /**< pula miast */
+  Pool neighs; /**< pula odcinków dróg */
+  Pool routeSets; /**< pula zbiorów dróg krajowych odcinków */
+  Pool listNodes; /**< pula elementów list */
+  Arena names; /**< arena nazw miast */
+  /*@}*/
+} Pools;
+
+/** @brief Inicjalizuje puste pule pamięci.
+ * @param[out] pools      - wskaźnik na pule
+ */
+void poolsInit(Pools *pools);
+
+/** @brief Zwalnia całą pamięć pul, a z nią wszystkie przydzielone z nich obiekty.
+ * @param[in, out] pools      - wskaźnik na pule
  */
-ListNode *createListNode(void *valPtr);
+void poolsDestroy(Pools *pools);
 
-/** @brief Tworzy nowy element typu dijkVal
- * @param[in] cityPtr      - wskaźnik na miasto
- * @param[in] actDist      - odległość
- * @param[in] actOldest      - najstarszy
+/** @brief Tworzy nowy element typu ListNode
+ * @param[in, out] pools      - wskaźnik na pule pamięci
+ * @param[in] valPtr      - wskaźnik na wartość
  * @return Zwraca wskaźnik na utworzony element.
  */
-dijkVal *createDijkVal(City *cityPtr, uint64_t actDist, int32_t actOldest);
+ListNode *createListNode(Pools *pools, void *valPtr);
 
 /** @brief Tworzy nowe miasto
+ * @param[in, out] pools      - wskaźnik na pule pamięci
  * @param[in] name      - nazwa miasta
  * @return Zwraca wskaźnik na utworzony element.
  */
-City *createCity(char *name);
+City *createCity(Pools *pools, const char *name);
 
 /** @brief Tworzy nowy element typu Neigh
+ * @param[in, out] pools      - wskaźnik na pule pamięci
  * @param[in] cityPtr      - wskaźnik na miasto docelowe
  * @param[in] length      - długość
  * @param[in] date      - rok budowy
  * @return Zwraca wskaźnik na utworzony element.
  */
-Neigh *createNeigh(City *cityPtr, uint32_t length, int32_t date);
+Neigh *createNeigh(Pools *pools, City *cityPtr, uint32_t length, int32_t date);
 
-/** @brief Tworzy nowy element typu TreapNode
- * @param[in] valPtr      - wskaźnik na wartość
- * @return Zwraca wskaźnik na utworzony element.
- */
-TreapNode *createTreapNode(void *valPtr);
-
-/** @brief Odwraca listę wskaźnikową odcinków drogowych.
- * @param[in] listPtr      - wskaźnik na początek listy
- * @param[out] target      - tu zostanie zapisany wskaźnik na nowo stworzoną listę
- * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
- */
-bool reverseNeighList(ListNode *listPtr, ListNode **target);
 /** @brief Usuwa listę.
+ * @param[in, out] pools      - wskaźnik na pule pamięci
  * @param[in] path      - wskaźnik na początek listy
  */
-void freeList(ListNode *path);
+void freeList(Pools *pools, ListNode *path);
 /** @brief Usuwa element typu Neigh.
+ * Zbiór localRoutes jest zwalniany razem z drugim z pary odcinków.
+ * @param[in, out] pools      - wskaźnik na pule pamięci
  * @param[in] neighPtr      - wskaźnik na Neigh
  */
-void deleteNeigh(Neigh *neighPtr);
+void deleteNeigh(Pools *pools, Neigh *neighPtr);
 
-/** @brief Alokuje pamięć i tworzy tablicę localRoutes dla podanego Neigh
- * @param[in] ptr      - wskaźnik na Neigh
+/** @brief Zaznacza, że droga krajowa przechodzi przez odcinek (w obu kierunkach).
+ * @param[in, out] pools      - wskaźnik na pule pamięci
+ * @param[in, out] neighPtr      - wskaźnik na Neigh
+ * @param[in] routeId      - numer drogi krajowej
  * @return Zwraca true w przypadku powodzenia, lub false jeśli nie udało się zaalokować pamięci.
  */
-bool neighRoutesInit(Neigh *ptr);
+bool neighAddRoute(Pools *pools, Neigh *neighPtr, uint32_t routeId);
+
+/** @brief Usuwa zaznaczenie drogi krajowej z odcinka (w obu kierunkach).
+ * @param[in, out] neighPtr      - wskaźnik na Neigh
+ * @param[in] routeId      - numer drogi krajowej
+ */
+void neighRemoveRoute(Neigh *neighPtr, uint32_t routeId);
 
 
 #endif /* __TYPES_H__ */
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <threads.h>
+#include <stdatomic.h>
+#include "workers.h"
+
+/** Największa obsługiwana liczba wątków roboczych. */
+#define MAX_WORKERS 64
+
+/**
+ * Wspólny stan wątków wykonujących zadania.
+ */
+typedef struct Batch {
+  /*@{*/
+  uint32_t count; /**< liczba zadań */
+  WorkerTask task; /**< zadanie */
+  void *context; /**< wspólne dane zadań */
+  atomic_uint next; /**< numer następnego zadania do pobrania */
+  atomic_bool failed; /**< informacja, czy któreś zadanie się nie powiodło */
+  /*@}*/
+} Batch;
+
+/**
+ * Argument wątku roboczego.
+ */
+typedef struct Worker {
+  /*@{*/
+  Batch *batch; /**< wspólny stan */
+  uint32_t id; /**< numer wątku */
+  /*@}*/
+} Worker;
+
+static int workerMain(void *arg){
+  Worker *worker = (Worker*)arg;
+  Batch *batch = worker->batch;
+
+  while(!atomic_load(&(batch->failed))){
+    uint32_t index = atomic_fetch_add(&(batch->next), 1);
+    if(index >= batch->count) break;
+    if(!batch->task(batch->context, worker->id, index)) atomic_store(&(batch->failed), true);
+  }
+  return 0;
+}
+
+bool runParallel(uint32_t count, uint32_t workers, WorkerTask task, void *context){
+  if(workers > count) workers = count;
+  if(workers > MAX_WORKERS) workers = MAX_WORKERS;
+
+  if(workers <= 1){
+    for(uint32_t i = 0; i < count; i++){
+      if(!task(context, 0, i)) return false;
+    }
+    return true;
+  }
+
+  Batch batch;
+  batch.count = count;
+  batch.task = task;
+  batch.context = context;
+  atomic_init(&(batch.next), 0);
+  atomic_init(&(batch.failed), false);
+
+  Worker args[MAX_WORKERS];
+  thrd_t threads[MAX_WORKERS];
+  uint32_t started = 1;
+  for(uint32_t w = 0; w < workers; w++){
+    args[w].batch = &batch;
+    args[w].id = w;
+  }
+  for(uint32_t w = 1; w < workers; w++){
+    if(thrd_create(&threads[started], workerMain, &args[started]) != thrd_success) break;
+    started++;
+  }
+
+  workerMain(&args[0]);
+  for(uint32_t w = 1; w < started; w++) thrd_join(threads[w], NULL);
+  return !atomic_load(&(batch.failed));
+}
@@ -0,0 +1,37 @@
+/** @file
+ * Równoległe wykonywanie niezależnych zadań na kilku wątkach.
+ *
+ * @author Jakub Organa
+ * @date 17.10.2026
+ */
+
+#ifndef __WORKERS_H__
+#define __WORKERS_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdbool.h>
+
+/** @brief Zadanie wykonywane przez wątek roboczy.
+ * @param[in, out] context      - wspólne dane zadań
+ * @param[in] worker      - numer wątku roboczego (od 0 do liczby wątków - 1)
+ * @param[in] index      - numer zadania
+ * @return Zwraca true w przypadku powodzenia, lub false jeśli zadanie się nie powiodło.
+ */
+typedef bool (*WorkerTask)(void *context, uint32_t worker, uint32_t index);
+
+/** @brief Wykonuje zadania o numerach od 0 do count - 1.
+ * Zadania są rozdzielane dynamicznie między co najwyżej workers wątków;
+ * wątek wywołujący jest wątkiem o numerze 0. Po pierwszym niepowodzeniu
+ * kolejne zadania nie są już rozpoczynane. Jeśli nie uda się utworzyć
+ * wątku, zadania wykonują wątki już działające.
+ * @param[in] count      - liczba zadań
+ * @param[in] workers      - maksymalna liczba wątków
+ * @param[in] task      - zadanie
+ * @param[in, out] context      - wspólne dane zadań
+ * @return Zwraca true, jeśli wszystkie zadania się powiodły.
+ */
+bool runParallel(uint32_t count, uint32_t workers, WorkerTask task, void *context);
+
+#endif /* __WORKERS_H__ */